@@ -0,0 +1,149 @@
+/**
+ * @file AdminControl.cpp
+ * @brief Admin command parsing and the lock-free command queue.
+ *
+ * The queue is the classic multi-producer single-consumer linked list with a
+ * dummy node: producers swap their node in as the new head with one atomic
+ * exchange and then link the previous head to it, the consumer follows the
+ * links from its tail. Nobody ever waits for anybody else. A producer preempted
+ * between the two steps only hides its command (and the ones behind it) until
+ * it links it.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "AdminControl.h"
+
+#include <stdint.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace
+{
+	std::string TrimmedArgument(const std::string& line, size_t start)
+	{
+		size_t first = line.find_first_not_of(" \t\r\n", start);
+		size_t last = line.find_last_not_of(" \t\r\n");
+		return first == std::string::npos ? "" : line.substr(first, last - first + 1);
+	}
+}
+
+bool ParseAdminCommand(const std::string& line, AdminCommand& command)
+{
+	static const struct
+	{
+		const char* prefix;
+		AdminCommand::Type type;
+	} withNickname[] = {
+		{ "/kick ", AdminCommand::Kick },
+		{ "/mute ", AdminCommand::Mute },
+		{ "/unmute ", AdminCommand::Unmute },
+	};
+
+	if (TrimmedArgument(line, 0) == "/kickall")
+	{
+		command.type = AdminCommand::KickAll;
+		command.nickname.clear();
+		return true;
+	}
+	for (const auto& entry : withNickname)
+	{
+		std::string prefix = entry.prefix;
+		if (line.compare(0, prefix.size(), prefix) == 0)
+		{
+			command.type = entry.type;
+			command.nickname = TrimmedArgument(line, prefix.size());
+			return !command.nickname.empty();
+		}
+	}
+	return false;
+}
+
+AdminQueue::AdminQueue()
+	: head(nullptr), tail(nullptr), wakePending(false)
+{
+	Node* stub = new Node();
+	stub->next.store(nullptr, std::memory_order_relaxed);
+	head.store(stub, std::memory_order_relaxed);
+	tail = stub;
+
+#if defined(__linux__)
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd >= 0)
+		wakeRead = wakeWrite = fd;
+#elif !defined(_WIN32)
+	int fds[2];
+	if (pipe(fds) == 0)
+	{
+		SetSocketNonBlocking(fds[0]);
+		SetSocketNonBlocking(fds[1]);
+		wakeRead = fds[0];
+		wakeWrite = fds[1];
+	}
+#endif
+}
+
+AdminQueue::~AdminQueue()
+{
+	AdminCommand command;
+	while (Poll(command))
+	{
+	}
+	delete tail;
+#ifndef _WIN32
+	if (wakeRead != INVALID_SOCKET)
+		close(wakeRead);
+	if (wakeWrite != INVALID_SOCKET && wakeWrite != wakeRead)
+		close(wakeWrite);
+#endif
+}
+
+void AdminQueue::Post(const AdminCommand& command)
+{
+	Node* node = new Node();
+	node->command = command;
+	node->next.store(nullptr, std::memory_order_relaxed);
+	Node* previous = head.exchange(node, std::memory_order_acq_rel);
+	previous->next.store(node, std::memory_order_release);
+	Wake();
+}
+
+bool AdminQueue::Poll(AdminCommand& command)
+{
+	Node* next = tail->next.load(std::memory_order_acquire);
+	if (next == nullptr)
+		return false;
+	command = std::move(next->command);
+	delete tail;
+	tail = next;
+	return true;
+}
+
+void AdminQueue::Wake()
+{
+	// One pending signal is enough; skip the system call while the loop has not consumed it yet
+	if (wakeWrite == INVALID_SOCKET || wakePending.exchange(true))
+		return;
+#ifndef _WIN32
+	uint64_t one = 1;
+	ssize_t written = write(wakeWrite, &one, wakeRead == wakeWrite ? sizeof(one) : 1);
+	(void)written;
+#endif
+}
+
+void AdminQueue::ClearWake()
+{
+#ifndef _WIN32
+	if (wakeRead == INVALID_SOCKET)
+		return;
+	uint64_t drained[8];
+	while (read(wakeRead, drained, sizeof(drained)) > 0)
+	{
+	}
+	// Only after draining, so a Post() racing with this call still leaves a signal behind
+	wakePending.store(false);
+#endif
+}
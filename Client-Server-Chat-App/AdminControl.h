@@ -0,0 +1,105 @@
+#pragma once
+/**
+ * @file AdminControl.h
+ * @brief Server console commands handed to the relay loop without locking it.
+ *
+ * The console thread never touches clients itself. Commands that change state
+ * (/kick, /kickall, /mute, /unmute) are posted to an AdminQueue, a lock-free
+ * multi-producer queue that the server loop drains between two select() calls.
+ * Posting also wakes the loop up through an eventfd (a pipe on other POSIX
+ * systems), so a command does not wait for the next client message. Windows
+ * has no descriptor select() could watch for this, so there the loop wakes up
+ * every ADMIN_POLL_MS instead.
+ *
+ * Read-only commands (/users, /who) are answered from the user snapshot the
+ * relay engine publishes (see RelayEngine::Users()), so they do not reach the
+ * loop at all.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "SocketCompat.h"
+
+#include <atomic>
+#include <string>
+
+// Longest a posted command may wait when the loop cannot be woken up (Windows), in milliseconds
+#define ADMIN_POLL_MS 50
+
+// Commands run per pass of the server loop, so a flood of them cannot starve the clients
+#define ADMIN_COMMANDS_PER_PASS 256
+
+/**
+ * @brief A state-changing console command.
+ */
+struct AdminCommand
+{
+	enum Type
+	{
+		Kick,    // Disconnect the client using nickname
+		KickAll, // Disconnect every client
+		Mute,    // Stop relaying what nickname says, also after reconnecting
+		Unmute
+	};
+
+	Type type = Kick;
+	std::string nickname;
+};
+
+/**
+ * @brief Parses a console line into a command for the loop.
+ * @return false if the line is not one of /kick, /kickall, /mute or /unmute (with their nickname).
+ */
+bool ParseAdminCommand(const std::string& line, AdminCommand& command);
+
+/**
+ * @brief Lock-free queue of admin commands from any thread to the server loop.
+ */
+class AdminQueue
+{
+public:
+	AdminQueue();
+	~AdminQueue();
+
+	AdminQueue(const AdminQueue&) = delete;
+	AdminQueue& operator=(const AdminQueue&) = delete;
+
+	/**
+	 * @brief Queues a command and wakes the loop up. Safe to call from any thread.
+	 */
+	void Post(const AdminCommand& command);
+
+	/**
+	 * @brief Takes the oldest command. Only the loop thread may call this.
+	 * @return false if the queue is empty.
+	 */
+	bool Poll(AdminCommand& command);
+
+	/**
+	 * @brief Makes the wake-up descriptor readable, e.g. when the loop left commands for its next pass.
+	 */
+	void Wake();
+
+	// Descriptor that becomes readable after Post(), or INVALID_SOCKET if there is none
+	socket_t WakeHandle() const { return wakeRead; }
+
+	/**
+	 * @brief Resets the wake-up descriptor; call it before polling when select() reported it.
+	 */
+	void ClearWake();
+
+private:
+	struct Node
+	{
+		std::atomic<Node*> next;
+		AdminCommand command;
+	};
+
+	// Producers append behind head; the consumer owns tail, a node whose command was already taken
+	std::atomic<Node*> head;
+	Node* tail;
+	std::atomic<bool> wakePending;
+	socket_t wakeRead = INVALID_SOCKET;
+	socket_t wakeWrite = INVALID_SOCKET;
+};
@@ -1,12 +1,11 @@
-﻿#pragma once
-/**
+﻿/**
  * @file Client.cpp
- * @brief Simple Windows chat client using Winsock and multithreading.
+ * @brief Simple chat client for Windows and Linux using multithreading.
  *
- * Connects to a TCP server (by default, on localhost port 8080), sends user input, and
- * receives messages from the server in a separate thread. Uses the Windows
- * Sockets API for networking and Windows threads for concurrent message
- * reception.
+ * Connects to a server (by default, on localhost port 8080), sends user input, and
+ * receives messages from the server in a separate thread. The connection goes
+ * through the transport layer (see Transport.h), so the server may also be
+ * reached over a Unix domain socket ("unix:/path/to/socket").
  *
  * Features:
  * - Establishes a connection to the server.
@@ -14,9 +13,13 @@
  * - Receives and displays messages from the server asynchronously.
  * - Attempts to reconnect if the connection is lost.
  * - Uses colored text for system, user, and error messages.
+ * - Frames every message (see Framing.h) and coalesces outgoing frames (see OutputBatcher.h).
+ * - Announces its nickname on every (re)connection, which lets the server deliver missed messages.
+ * - Renders everything a read delivered as one colored batch, written once per frame
+ *   tick with rate-limited notifications (see ConsoleRenderer.h).
  * @author Nikita Struk
  * @date May 30, 2025
- * Last updated: June 19, 2025
+ * Last updated: October 18, 2026
  */
 
 #include <iostream>
@@ -24,38 +27,50 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#include <windows.h>
 #include <atomic>
+#include <mutex>
 #include <thread>
+#include <vector>
 #include <chrono>
 #include <fstream>
 #include <iomanip> // Adding this include for std::put_time
 
+#include "ConsoleRenderer.h"
+#include "Framing.h"
+#include "OutputBatcher.h"
+#include "Transport.h"
 
-
-#pragma comment(lib, "ws2_32.lib")
+#ifdef _WIN32
+#include <windows.h>
+#else
+typedef unsigned short WORD;
+#endif
 
 // Define the buffer size for sending and receiving messages
 #define BUFFER_SIZE 1024
 
+// Bytes taken from the connection per read; one read may complete many messages
+#define RECEIVE_CHUNK_SIZE 65536
+
 // Delay before attempting to reconnect in seconds
 #define RECONNECT_DELAY_SECONDS 5 
 
-// Console color codes for Windows
-#define COLOR_DEFAULT 7
+// Console color codes (Windows console attributes, translated to ANSI elsewhere)
+#define COLOR_DEFAULT TERMINAL_COLOR // Until /color default: the terminal's own color
 #define COLOR_SYSTEM 11
 #define COLOR_USER 10
 #define COLOR_ERROR 12
 
 
 
-//User-customizable color variables
-WORD g_colorDefault = COLOR_DEFAULT;
-WORD g_colorSystem = COLOR_SYSTEM;
-WORD g_colorUser = COLOR_USER;
-WORD g_colorError = COLOR_ERROR;
+//User-customizable color variables (read by the receive thread, changed by /color)
+std::atomic<WORD> g_colorDefault(COLOR_DEFAULT);
+std::atomic<WORD> g_colorSystem(COLOR_SYSTEM);
+std::atomic<WORD> g_colorUser(COLOR_USER);
+std::atomic<WORD> g_colorError(COLOR_ERROR);
+
+// All console output goes through here, so the input and receive threads never interleave color changes
+ConsoleRenderer g_console(stdout);
 
 void PrintSystem(const char* message);
 
@@ -63,8 +78,8 @@ void PrintSystem(const char* message);
 void PrintColorHelp()
 {
 	PrintSystem("Available color codes (foreground):\n");
-	printf("0: Black\n1: Blue\n2: Green\n3: Aqua\n4: Red\n5: Purple\n6: Yellow\n7: White\n8: Gray");
-	printf("\n9: Light Blue\n10: Light Green\n11: Light Aqua\n12: Light Red\n13: Light Purple\n14: Light Yellow\n15: Bright White\n");
+	g_console.Print(g_colorDefault, "0: Black\n1: Blue\n2: Green\n3: Aqua\n4: Red\n5: Purple\n6: Yellow\n7: White\n8: Gray");
+	g_console.Print(g_colorDefault, "\n9: Light Blue\n10: Light Green\n11: Light Aqua\n12: Light Red\n13: Light Purple\n14: Light Yellow\n15: Bright White\n");
 	PrintSystem("Usage: /color <type> <code>\n");
 	PrintSystem("Types: system, user, error, default\n");
 }
@@ -72,35 +87,48 @@ void PrintColorHelp()
  // Shared flag to signal disconnection
 std::atomic<bool> isDisconnected(false);
 
-//Helper function to set console text color
-void SetConsoleColor(WORD color)
+// Nickname messages are sent under; the receive thread switches it when the server confirms a /nick
+std::mutex g_nicknameMutex;
+std::string g_nickname;
+
+std::string CurrentNickname()
 {
-    static HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-	SetConsoleTextAttribute(hConsole, color);
+	std::lock_guard<std::mutex> lock(g_nicknameMutex);
+	return g_nickname;
+}
+
+void SetNickname(const std::string& nickname)
+{
+	std::lock_guard<std::mutex> lock(g_nicknameMutex);
+	g_nickname = nickname;
+}
+
+// Takes the new nickname out of the server's "/nick" confirmation, a control frame no other client can send
+bool ParseNicknameConfirmation(const std::string& message, std::string& nickname)
+{
+	const std::string prefix = NICKNAME_CONFIRMATION_PREFIX;
+	if (message.compare(0, prefix.length(), prefix) != 0 || message.length() == prefix.length())
+		return false;
+	nickname = message.substr(prefix.length());
+	return true;
 }
 
 //Print system/info message in cyan color
 void PrintSystem(const char* message)
 {
-    SetConsoleColor(g_colorSystem);
-    printf("%s", message);
-    SetConsoleColor(g_colorDefault);
+    g_console.Print(g_colorSystem, message);
 }
 
 //Print user message in green color
 void PrintUser(const char* message)
 {
-    SetConsoleColor(g_colorUser);
-    printf("%s", message);
-	SetConsoleColor(g_colorDefault);
+    g_console.Print(g_colorUser, message);
 }
 
 // Print error message in red color
 void PrintError(const char* message)
 {
-    SetConsoleColor(g_colorError);
-    printf("%s", message);
-    SetConsoleColor(g_colorDefault);
+    g_console.Print(g_colorError, message);
 }
 
 void HandleColorCommand(const char* buffer)
@@ -109,7 +137,11 @@ void HandleColorCommand(const char* buffer)
 	char type[16];
 	int code;
 	// FIX: Pass buffer size for %s argument as required by sscanf_s
+#ifdef _WIN32
 	int matched = sscanf_s(buffer, "/color %15s %d", type, (unsigned)_countof(type), &code);
+#else
+	int matched = sscanf(buffer, "/color %15s %d", type, &code);
+#endif
 
 	if (matched != 2 || code < 0 || code > 15)
 	{
@@ -135,6 +167,7 @@ void HandleColorCommand(const char* buffer)
 	else if (strcmp(type, "default") == 0)
 	{
 		g_colorDefault = (WORD)code;
+		g_console.SetDefaultColor((WORD)code);
 		PrintSystem("Default color updated.\n");
 	}
 	else
@@ -157,7 +190,11 @@ void LogMessage(const std::string& message)
 
         // Convert time_t to tm structure
         std::tm localTime;
+#ifdef _WIN32
         localtime_s(&localTime, &currentTime); // Use localtime_s for thread safety
+#else
+        localtime_r(&currentTime, &localTime);
+#endif
 
         // Log the message with timestamp
         logFile << std::put_time(&localTime, "(%m/%d/%H:%M)") << " " << message << std::endl;
@@ -172,138 +209,149 @@ void LogMessage(const std::string& message)
  * @brief Function to receive messages from the server in a separate thread.
  * 
  * This function runs in a loop, receiving messages from the server and printing them to the console.
- * If the connection is lost, it sets the isDisconnected flag to true.
+ * Every message a read completed is formatted into one batch, handed to the renderer with a single
+ * notification. If the connection is lost, it sets the isDisconnected flag to true.
  * 
- * @param socket_desc Pointer to the socket descriptor.
- * @return DWORD Returns 0 on success.
+ * @param connection The connection to the server.
 */
 
-DWORD WINAPI receive_messages(LPVOID socket_desc) 
+void receive_messages(Connection* connection) 
 {
-	int sock = *(int*)socket_desc;
-	char buffer[BUFFER_SIZE];
-	int valread;
+	std::vector<char> chunk(RECEIVE_CHUNK_SIZE);
+	long valread;
+	FrameReader reader;
+	std::string message;
+	std::string batch;
 	while (1) 
     {
-		memset(buffer, 0, BUFFER_SIZE);
-		valread = recv(sock, buffer, BUFFER_SIZE - 1, 0);
-        if (valread <= 0)
+		valread = connection->Recv(chunk.data(), chunk.size());
+        if (valread > 0)
+        {
+			reader.Feed(chunk.data(), (size_t)valread);
+        }
+        if (valread <= 0 || reader.HasError())
         {
 			PrintSystem("Connection lost. Attempting to reconnect...\n");
 			isDisconnected = true;
             break;
         }
 
-		buffer[valread] = '\0';
-
-		MessageBeep(MB_ICONEXCLAMATION); // Beep to notify user of new message)
-
-        // Print user messages in green, system messages in cyan
-		// Heuristic: if message contains ":", it's a user message, else system
-        if (strstr(buffer, ": ") == buffer + 0)
-        {
-            //Unlikely, but fallback
-			PrintUser(buffer);
-            printf("\n");
-        }
-        else if (strstr(buffer, ": "))
-        {
-			PrintUser(buffer);
-            printf("\n");
-        }
-        else
+		// One read may complete several messages, or none
+		size_t lines = 0;
+		batch.clear();
+		while (reader.Next(message))
 		{
-            PrintSystem(buffer);
-			printf("\n");
-        }
+			// Control frames from the server are acted upon, not printed as they are
+			if (message.compare(0, strlen(CONTROL_FRAME_PREFIX), CONTROL_FRAME_PREFIX) == 0)
+			{
+				std::string confirmed;
+				if (!ParseNicknameConfirmation(message, confirmed))
+					continue; // Unknown to this client
+				SetNickname(confirmed);
+				message = "Your nickname is now '" + confirmed + "'.";
+			}
+			// Print user messages in green, system messages in cyan
+			// Heuristic: if message contains ": ", it's a user message, else system
+			WORD color = message.find(": ") != std::string::npos ? g_colorUser : g_colorSystem;
+			g_console.Format(batch, color, message.data(), message.size());
+			batch += '\n';
+			lines++;
+		}
+		if (lines > 0)
+		{
+			g_console.Write(batch, lines);
+			g_console.Notify(); // Beep to notify user of new messages, at most once per interval
+		}
 	}
-	return 0;
 }
 
-/*
-* Helper function to connect to the server
-* @param sock Reference to the socket descriptor
-* @param serverAddress The address of the server to connect to
-* Returns true if connection is successful, false otherwise
-*/
-
-bool ConnectToServer(int& sock, const std::string& serverAddress, unsigned int serverPort)
+/**
+ * @brief Queues a message for the server and flushes it once its batching window is over.
+ * @return false if the connection is broken.
+ */
+bool SendToServer(OutputBatcher& batcher, Connection* connection, const char* message, size_t length)
 {
-	struct sockaddr_in serv_addr;
-	sock = socket(AF_INET, SOCK_STREAM, 0);
-    if(sock < 0) 
-    {
-        PrintError("Socket creation failed");
-        return false;
-	}
-	serv_addr.sin_family = AF_INET;
-	serv_addr.sin_port = htons(serverPort);
-    if (inet_pton(AF_INET, serverAddress.c_str(), &serv_addr.sin_addr) <= 0)
-    {
-        PrintError("Invalid address");
-        closesocket(sock);
-        return false;
-    }
-    if (connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0)
-    {
-        closesocket(sock);
-		return false;
-    }
-    return true;
+	batcher.Queue(connection, message, length);
+	batcher.FlushDue();
+	return !batcher.IsBroken(connection);
 }
 
 void InitializeClient(const std::string& serverAddress, 
                       const unsigned int& serverPort, 
-                      std::string userNickname)
+                      std::string userNickname,
+                      const BatchingOptions& batching)
 {  
-    WSADATA wsaData;
-    int sock = 0;
-    struct sockaddr_in serv_addr;
+    std::unique_ptr<Connection> connection;
     char buffer[BUFFER_SIZE];
 
-    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    // "unix:/path" selects a Unix domain socket; anything else is a TCP host
+    std::string endpoint;
+    std::unique_ptr<Transport> transport = CreateTransportFor(serverAddress, endpoint);
+    if (!transport)
     {
-        PrintError("WSAStartup failed\n");
+        PrintError("This transport is not supported on this platform\n");
         exit(EXIT_FAILURE);
     }
+    if (strcmp(transport->Name(), "tcp") == 0)
+    {
+        endpoint += ":" + std::to_string(serverPort);
+    }
+
+    SetNickname(userNickname);
+
+    // Colors need ANSI support from the console (always there outside Windows)
+    g_console.SetColors(EnableConsoleAnsi());
+    g_console.Start();
+
+    // Outgoing messages are coalesced; with a non-zero window (--batch-window-us) a timer thread flushes expired batches
+    OutputBatcher batcher(batching);
+    const unsigned int batchWindowMicros = batcher.Options().windowMicros;
+    std::atomic<bool> flusherRunning(batchWindowMicros > 0);
+    std::thread flusher;
+    if (flusherRunning)
+    {
+        flusher = std::thread([&batcher, &flusherRunning, batchWindowMicros]()
+        {
+            while (flusherRunning)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(batchWindowMicros));
+                batcher.FlushDue();
+            }
+        });
+    }
 
 reconnect_label:
 	// If the user didn't connect successfully, try to reconnect up to "connectionAttempts" times
 	unsigned int connectionAttempts = 0;
     isDisconnected = false;
     PrintSystem("Connecting to the server...\n");
-    while (!ConnectToServer(sock, serverAddress, serverPort) && connectionAttempts < 3)
+    while (!(connection = transport->Connect(endpoint)) && connectionAttempts < 3)
     {
 		PrintError("Connection failed. Retrying...\n");
-        SetConsoleColor(g_colorSystem);
-        printf("%d", RECONNECT_DELAY_SECONDS);
-        SetConsoleColor(g_colorError);
-		printf(" seconds...\n");
-        SetConsoleColor(g_colorDefault);
+        PrintSystem(std::to_string(RECONNECT_DELAY_SECONDS).c_str());
+		PrintError(" seconds...\n");
         std::this_thread::sleep_for(std::chrono::seconds(RECONNECT_DELAY_SECONDS));
 		connectionAttempts++;
         if (connectionAttempts >= 3)
         {
             PrintError("Failed to connect after 3 attempts. Exiting...\n");
-            WSACleanup();
 			exit(EXIT_FAILURE);
         }
     }
 
     PrintSystem("Connected to the server.\n");
+    batcher.Attach(connection.get());
 
-    HANDLE thread_handle = CreateThread(NULL, 0, receive_messages, &sock, 0, NULL);
-    if (thread_handle == NULL)
-    {
-        PrintError("Thread creation failed");
-        closesocket(sock);
-        WSACleanup();
-		exit(EXIT_FAILURE);
-    }
+    std::thread receiver(receive_messages, connection.get());
+    // Announce the nickname so the server delivers what was said while we were away
+    std::string hello = "/hello " + CurrentNickname();
+    SendToServer(batcher, connection.get(), hello.c_str(), hello.length());
     while (1)
     {
         PrintSystem("Enter message: ");
-		fgets(buffer, BUFFER_SIZE, stdin);
+		// stdin closed (e.g. started by a script): quit instead of resending the last line forever
+		if (fgets(buffer, BUFFER_SIZE, stdin) == NULL)
+			snprintf(buffer, BUFFER_SIZE, "/quit");
         //Remove trailing newline from gets
 		buffer[strcspn(buffer, "\n")] = 0;
 		// Handle /color command locally
@@ -323,8 +371,7 @@ reconnect_label:
         //Handle /users command: send to server, display response
         if (strcmp(buffer, "/users") == 0)
         {
-			int sendResult = send(sock, "/users", (int)strlen(buffer), 0);
-            if (sendResult == SOCKET_ERROR)
+            if (!SendToServer(batcher, connection.get(), "/users", strlen(buffer)))
             {
                 PrintError("Failed to request user list. Attempting to reconnect...\n");
                 isDisconnected = true;
@@ -346,39 +393,33 @@ reconnect_label:
                 PrintError("Nickname cannot be empty. Please enter a valid nickname.\n");
 				continue;
             }
-            if (newNickname.length() > 32)
+            if (newNickname.length() > MAX_NICKNAME_LENGTH)
             {
                 PrintError("Nickname too long (max 32 characters). \n");
 				continue;
             }
-            std::string oldNickname = userNickname;
-			userNickname = newNickname; // Update the nickname
-			//Inform the server about the nickname change
-            std::string sysMsg = oldNickname + " changed nickname to " + userNickname;
-			int sendResult = send(sock, sysMsg.c_str(), (int)sysMsg.length(), 0);
-            LogMessage("[NICK] " + sysMsg);
-            if (sendResult == SOCKET_ERROR)
+            if (newNickname.find(':') != std::string::npos)
+            {
+                PrintError("Nickname cannot contain ':'.\n");
+				continue;
+            }
+			//Ask the server; the nickname changes when its confirmation arrives (see receive_messages)
+            std::string nickCommand = "/nick " + newNickname;
+			bool sent = SendToServer(batcher, connection.get(), nickCommand.c_str(), nickCommand.length());
+            LogMessage("[NICK] " + CurrentNickname() + " asked for " + newNickname);
+            if (!sent)
             {
-                // Fix: Ensure `userNickname` is a mutable variable and matches the type of `newNickname`.  
-                // Update the declaration of `userNickname` to be a `std::string` if it isn't already.  
-
-                std::string userNickname; // Ensure this is declared as a std::string  
-
-                // Modify the assignment to ensure compatibility.  
-                userNickname = newNickname; // Update the nickname
 				PrintError("Failed to send nickname change to server. Attempting to reconnect.\n");
                 isDisconnected = true;
                 break;
             }
-			PrintSystem("Nickname updated\n");
             continue;
         }
 
 
 		//Convert buffer to lowercase for case-insensitive comparison
 		char lower_buffer[BUFFER_SIZE];
-		strncpy_s(lower_buffer, buffer, BUFFER_SIZE);
-		lower_buffer[BUFFER_SIZE - 1] = '\0'; // Ensure null termination
+		snprintf(lower_buffer, BUFFER_SIZE, "%s", buffer); // Always null-terminated
         for (int i = 0; lower_buffer[i]; i++)
             lower_buffer[i] = (char)tolower((unsigned char) lower_buffer[i]);
         /*
@@ -387,9 +428,18 @@ reconnect_label:
         */
         if (strcmp(lower_buffer, "/quit") == 0 || strcmp(lower_buffer, "/exit") == 0)
         {
-            closesocket(sock);
-            WSACleanup();
+            // Nothing typed before /quit may be lost in a pending batch
+            batcher.FlushAll();
+            batcher.Detach(connection.get());
+            // Wakes up the receive thread so it can exit
+            connection->Shutdown();
+            receiver.join();
+            connection->Close();
+            flusherRunning = false;
+            if (flusher.joinable())
+                flusher.join();
             isDisconnected = false;
+            g_console.Stop();
             return;
         }
         if (strlen(buffer) == 0)
@@ -398,37 +448,41 @@ reconnect_label:
             continue;
         }
         //Check for overly long messages (after nickname is prepended)
-		std::string messageWithNickname = userNickname + ": " + buffer;
+		const std::string nickname = CurrentNickname();
+		std::string messageWithNickname = nickname + ": " + buffer;
         if (messageWithNickname.length() >= BUFFER_SIZE)
         {
 			PrintError("Message too long. Please limit your message to ");
-			SetConsoleColor(COLOR_SYSTEM);
-			printf("%zu", BUFFER_SIZE - userNickname.length() - 2); // 2 for ": "
-			SetConsoleColor(COLOR_ERROR);
-			printf(" characters.\n");
-			SetConsoleColor(COLOR_DEFAULT);
+			PrintSystem(std::to_string(BUFFER_SIZE - nickname.length() - 2).c_str()); // 2 for ": "
+			PrintError(" characters.\n");
         }
         //If disconnected, break to reconnect
         if (isDisconnected)
             break;
 		//Prepend the nickname to the message
-        int sendResult = send(sock,
-                              messageWithNickname.c_str(),
-                              (int)messageWithNickname.length(), 0);
+        bool sent = SendToServer(batcher,
+                                 connection.get(),
+                                 messageWithNickname.c_str(),
+                                 messageWithNickname.length());
 
 		LogMessage(messageWithNickname); // Log the message with timestamp
 
-        if (sendResult == SOCKET_ERROR)
+        if (!sent)
         {
             PrintError("Send failed. Attempting to reconnect...\n");
             isDisconnected = true;
             break;
         }
     }
-    closesocket(sock);
-	//Wait a moment to ensure the receive thread exits cleanly
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    batcher.Detach(connection.get());
+    connection->Shutdown();
+	//Wait for the receive thread to exit cleanly
+    receiver.join();
+    connection->Close();
     if (isDisconnected)
         goto reconnect_label;
-    WSACleanup();
+    flusherRunning = false;
+    if (flusher.joinable())
+        flusher.join();
+    g_console.Stop();
 }
\ No newline at end of file
@@ -0,0 +1,214 @@
+/**
+ * @file ConsoleRenderer.cpp
+ * @brief Render thread, ANSI formatting and notification rate limit of the console renderer.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "ConsoleRenderer.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#endif
+
+namespace
+{
+	// Console attributes are blue/green/red/intensity bits, ANSI colors are red/green/blue
+	void AppendAnsiColor(std::string& out, unsigned short color)
+	{
+		if (color == TERMINAL_COLOR)
+		{
+			out += "\033[0m";
+			return;
+		}
+		int ansi = ((color & 4) ? 1 : 0) | ((color & 2) ? 2 : 0) | ((color & 1) ? 4 : 0);
+		out += "\033[";
+		out += std::to_string(((color & 8) ? 90 : 30) + ansi);
+		out += 'm';
+	}
+}
+
+ConsoleRenderer::ConsoleRenderer(FILE* out, const RenderOptions& options)
+	: out(out), options(options), defaultColor(TERMINAL_COLOR), colors(options.colors),
+	  lastNotify(Clock::now() - std::chrono::milliseconds(options.notifyIntervalMs))
+{
+}
+
+ConsoleRenderer::~ConsoleRenderer()
+{
+	Stop();
+}
+
+void ConsoleRenderer::Start()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (running)
+		return;
+	running = true;
+	stopping = false;
+	thread = std::thread(&ConsoleRenderer::RenderLoop, this);
+}
+
+void ConsoleRenderer::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running || stopping)
+			return;
+		stopping = true;
+	}
+	pendingReady.notify_all();
+	spaceFree.notify_all();
+	thread.join();
+	std::lock_guard<std::mutex> lock(mutex);
+	running = false;
+	stopping = false;
+}
+
+void ConsoleRenderer::Format(std::string& out, unsigned short color, const char* text, size_t length) const
+{
+	if (!colors)
+	{
+		out.append(text, length);
+		return;
+	}
+	unsigned short restore = defaultColor;
+	if (color != restore)
+		AppendAnsiColor(out, color);
+	out.append(text, length);
+	if (color != restore)
+		AppendAnsiColor(out, restore);
+}
+
+void ConsoleRenderer::Write(const std::string& text, size_t lines)
+{
+	if (text.empty())
+		return;
+	std::unique_lock<std::mutex> lock(mutex);
+	stats.lines += lines;
+	if (!running || stopping)
+	{
+		// No render thread: write at once, in the caller's order
+		std::string copy = text;
+		Emit(copy, false);
+		return;
+	}
+	spaceFree.wait(lock, [this] { return pending.size() < options.maxPendingBytes || stopping; });
+	bool wasEmpty = pending.empty();
+	pending += text;
+	if (wasEmpty)
+		pendingReady.notify_one();
+}
+
+void ConsoleRenderer::Print(unsigned short color, const char* text)
+{
+	std::string formatted;
+	Format(formatted, color, text, strlen(text));
+	Write(formatted);
+}
+
+void ConsoleRenderer::Notify()
+{
+	if (options.notifyIntervalMs == 0)
+		return;
+	std::lock_guard<std::mutex> lock(mutex);
+	Clock::time_point now = Clock::now();
+	if (now - lastNotify < std::chrono::milliseconds(options.notifyIntervalMs))
+	{
+		stats.suppressed++;
+		return;
+	}
+	lastNotify = now;
+	if (!running || stopping)
+	{
+		std::string nothing;
+		Emit(nothing, true);
+		return;
+	}
+	notifyPending = true;
+	pendingReady.notify_one();
+}
+
+RenderStats ConsoleRenderer::Stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+// Called with the lock held, or by the render thread on text nobody else touches
+void ConsoleRenderer::Emit(std::string& text, bool notify)
+{
+	if (notify)
+	{
+#ifdef _WIN32
+		MessageBeep(MB_ICONEXCLAMATION);
+#else
+		// The terminal bell travels in the same write
+		text += '\a';
+#endif
+	}
+	if (!text.empty())
+	{
+		fwrite(text.data(), 1, text.size(), out);
+		fflush(out);
+	}
+}
+
+void ConsoleRenderer::RenderLoop()
+{
+	std::string writing;
+	Clock::time_point lastWrite;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		pendingReady.wait(lock, [this] { return !pending.empty() || notifyPending || stopping; });
+		if (pending.empty() && !notifyPending)
+			break; // Stopping, and everything has been written
+
+		// Whatever arrives until the next tick joins this write; after a quiet period the tick is already due
+		Clock::time_point due = lastWrite + std::chrono::microseconds(options.frameMicros);
+		pendingReady.wait_until(lock, due, [this] { return stopping; });
+
+		writing.swap(pending);
+		bool notify = notifyPending;
+		notifyPending = false;
+		spaceFree.notify_all();
+		lock.unlock();
+
+		Emit(writing, notify);
+		size_t written = writing.size();
+		writing.clear();
+		lastWrite = Clock::now();
+
+		lock.lock();
+		if (written > 0)
+		{
+			stats.writes++;
+			stats.bytes += written;
+		}
+		if (notify)
+			stats.notifications++;
+	}
+}
+
+bool EnableConsoleAnsi()
+{
+#ifdef _WIN32
+	HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD mode = 0;
+	if (console == INVALID_HANDLE_VALUE || !GetConsoleMode(console, &mode))
+		return false;
+	return SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+#else
+	return true;
+#endif
+}
@@ -0,0 +1,160 @@
+#pragma once
+/**
+ * @file ConsoleRenderer.h
+ * @brief Batched, colored console output for the chat client.
+ *
+ * Printing every received line with its own color switches, beep and write
+ * makes the console the bottleneck of a busy chat: the receive thread falls
+ * behind, and the unread data backs up into the server. The renderer splits
+ * that work:
+ *
+ * - the receive thread formats every message a read completed into one string,
+ *   colored with ANSI escape sequences, and hands it over with Write();
+ * - a render thread writes whatever has accumulated with a single write, at
+ *   most once per frame tick (frameMicros), so a flood of lines costs a few
+ *   dozen writes per second instead of one per line;
+ * - notifications (the beep for a new message) are limited to one per
+ *   notifyIntervalMs; the ones in between are dropped.
+ *
+ * A line arriving after a quiet period is written at once; only lines that
+ * follow it within the same tick wait for the next one. If the console cannot
+ * keep up at all, Write() blocks once maxPendingBytes are waiting, which slows
+ * the receive thread down as before instead of growing without bound.
+ *
+ * Colors are console color codes 0-15 (the Windows attribute numbering used by
+ * /color), translated to ANSI. On Windows the console must have virtual
+ * terminal processing enabled, see EnableConsoleAnsi().
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Default shortest time between two console writes, in microseconds (about 60 per second)
+#define DEFAULT_RENDER_FRAME_US 16000
+
+// Default shortest time between two new-message notifications, in milliseconds
+#define DEFAULT_NOTIFY_INTERVAL_MS 1000
+
+// Default amount of formatted output that may wait for the console before Write() blocks
+#define DEFAULT_RENDER_MAX_PENDING (4 * 1024 * 1024)
+
+// Color code meaning "whatever the terminal was using": no color switch, reset with \033[0m
+#define TERMINAL_COLOR 0xFFFF
+
+/**
+ * @brief Tuning of a ConsoleRenderer.
+ */
+struct RenderOptions
+{
+	unsigned int frameMicros = DEFAULT_RENDER_FRAME_US;
+	unsigned int notifyIntervalMs = DEFAULT_NOTIFY_INTERVAL_MS; // 0 disables notifications
+	size_t maxPendingBytes = DEFAULT_RENDER_MAX_PENDING;
+	bool colors = true; // Emit ANSI color sequences
+};
+
+/**
+ * @brief Counters for benchmarks and diagnostics.
+ */
+struct RenderStats
+{
+	unsigned long long lines = 0;          // Lines handed to Write()
+	unsigned long long writes = 0;         // Console writes performed
+	unsigned long long bytes = 0;          // Bytes written
+	unsigned long long notifications = 0;  // Notifications emitted
+	unsigned long long suppressed = 0;     // Notifications dropped by the rate limit
+};
+
+/**
+ * @brief Queues formatted text and writes it out once per frame tick.
+ *
+ * Thread-safe. Until Start() and after Stop(), Write() goes straight to the
+ * output, so the renderer can be used before the client is running.
+ */
+class ConsoleRenderer
+{
+public:
+	explicit ConsoleRenderer(FILE* out, const RenderOptions& options = RenderOptions());
+	~ConsoleRenderer();
+
+	ConsoleRenderer(const ConsoleRenderer&) = delete;
+	ConsoleRenderer& operator=(const ConsoleRenderer&) = delete;
+
+	/**
+	 * @brief Starts the render thread.
+	 */
+	void Start();
+
+	/**
+	 * @brief Writes what is still pending and stops the render thread.
+	 */
+	void Stop();
+
+	/**
+	 * @brief Appends text in a color to out, followed by a switch back to the default color.
+	 *
+	 * Until SetDefaultColor() is called the default is TERMINAL_COLOR, so the
+	 * switch back is a reset to the terminal's own attributes.
+	 */
+	void Format(std::string& out, unsigned short color, const char* text, size_t length) const;
+
+	/**
+	 * @brief Queues formatted text for the next frame.
+	 * @param lines Number of lines in text, for the statistics.
+	 */
+	void Write(const std::string& text, size_t lines = 0);
+
+	/**
+	 * @brief Formats and queues text in a color.
+	 */
+	void Print(unsigned short color, const char* text);
+
+	/**
+	 * @brief Asks for a new-message notification, unless one was given within notifyIntervalMs.
+	 */
+	void Notify();
+
+	// Color restored after every formatted piece of text (TERMINAL_COLOR: reset to the terminal's own)
+	void SetDefaultColor(unsigned short color) { defaultColor = color; }
+
+	void SetColors(bool enabled) { colors = enabled; }
+
+	const RenderOptions& Options() const { return options; }
+
+	RenderStats Stats() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	void RenderLoop();
+	void Emit(std::string& text, bool notify);
+
+	FILE* out;
+	RenderOptions options;
+	std::atomic<unsigned short> defaultColor;
+	std::atomic<bool> colors;
+
+	mutable std::mutex mutex;
+	std::condition_variable pendingReady; // Something to write, or stopping
+	std::condition_variable spaceFree;    // pending was taken by the render thread
+	std::string pending;
+	bool notifyPending = false;
+	bool running = false;
+	bool stopping = false;
+	Clock::time_point lastNotify; // Last notification let through, one interval back at first
+	RenderStats stats;
+	std::thread thread;
+};
+
+/**
+ * @brief Lets the console interpret ANSI escape sequences (Windows 10 and later).
+ * @return false if the console does not support them; elsewhere always true.
+ */
+bool EnableConsoleAnsi();
@@ -0,0 +1,706 @@
+/**
+ * @file Federation.cpp
+ * @brief Implementation of the inter-node relay bus and the nickname registry.
+ *
+ * Wire format of a frame payload: one type byte followed by fields. Strings are
+ * a 2-byte big-endian length plus the bytes, versions are 8 bytes big-endian.
+ *
+ * - HELLO:     node id
+ * - CHAT:      origin node id, then the chat line up to the end of the frame
+ * - NICKNAME:  nickname, owner node id, version, released flag (1 byte)
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Federation.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// Frame types carried on peer links
+#define FRAME_HELLO 1
+#define FRAME_CHAT 2
+#define FRAME_NICKNAME 3
+
+// Bytes read from one link per recv() call
+#define LINK_READ_CHUNK 65536
+
+namespace
+{
+	void PutString(std::string& out, const std::string& value)
+	{
+		size_t length = std::min(value.size(), (size_t)0xFFFF);
+		out.push_back((char)((length >> 8) & 0xFF));
+		out.push_back((char)(length & 0xFF));
+		out.append(value, 0, length);
+	}
+
+	void PutVersion(std::string& out, uint64_t value)
+	{
+		for (int shift = 56; shift >= 0; shift -= 8)
+			out.push_back((char)((value >> shift) & 0xFF));
+	}
+
+	// Sequential reader over a frame payload; any overrun clears ok
+	class FieldReader
+	{
+	public:
+		FieldReader(const std::string& payload, size_t start) : data(payload), pos(start) {}
+
+		std::string String()
+		{
+			if (data.size() - pos < 2)
+			{
+				ok = false;
+				return std::string();
+			}
+			size_t length = ((size_t)(unsigned char)data[pos] << 8) | (size_t)(unsigned char)data[pos + 1];
+			pos += 2;
+			if (data.size() - pos < length)
+			{
+				ok = false;
+				return std::string();
+			}
+			std::string value = data.substr(pos, length);
+			pos += length;
+			return value;
+		}
+
+		uint64_t Version()
+		{
+			if (data.size() - pos < 8)
+			{
+				ok = false;
+				return 0;
+			}
+			uint64_t value = 0;
+			for (int i = 0; i < 8; i++)
+				value = (value << 8) | (unsigned char)data[pos++];
+			return value;
+		}
+
+		unsigned char Byte()
+		{
+			if (pos >= data.size())
+			{
+				ok = false;
+				return 0;
+			}
+			return (unsigned char)data[pos++];
+		}
+
+		std::string Rest()
+		{
+			std::string value = data.substr(pos);
+			pos = data.size();
+			return value;
+		}
+
+		bool ok = true;
+
+	private:
+		const std::string& data;
+		size_t pos;
+	};
+
+	std::string EncodeHello(const std::string& node)
+	{
+		std::string payload(1, (char)FRAME_HELLO);
+		PutString(payload, node);
+		return payload;
+	}
+
+	std::string EncodeNickname(const std::string& nickname, const NicknameEntry& entry)
+	{
+		std::string payload(1, (char)FRAME_NICKNAME);
+		PutString(payload, nickname);
+		PutString(payload, entry.owner);
+		PutVersion(payload, entry.version);
+		payload.push_back(entry.released ? 1 : 0);
+		return payload;
+	}
+
+	// Entry a wins over entry b when it is newer, or equally new and owned by the smaller node id
+	bool Supersedes(const NicknameEntry& a, const NicknameEntry& b)
+	{
+		if (a.version != b.version)
+			return a.version > b.version;
+		if (a.owner != b.owner)
+			return a.owner < b.owner;
+		return a.released && !b.released;
+	}
+}
+
+bool ParsePeerList(const std::string& text, std::vector<PeerAddress>& peers)
+{
+	size_t start = 0;
+	while (start <= text.size())
+	{
+		size_t end = text.find(',', start);
+		if (end == std::string::npos)
+			end = text.size();
+		std::string item = text.substr(start, end - start);
+		item.erase(0, item.find_first_not_of(" \t\r\n"));
+		item.erase(item.find_last_not_of(" \t\r\n") + 1);
+		if (!item.empty())
+		{
+			size_t colon = item.rfind(':');
+			if (colon == std::string::npos || colon == 0 || colon + 1 == item.size())
+				return false;
+			int port = atoi(item.c_str() + colon + 1);
+			if (port <= 0 || port > 65535)
+				return false;
+			PeerAddress peer;
+			peer.host = item.substr(0, colon);
+			peer.port = (unsigned short)port;
+			peers.push_back(peer);
+		}
+		start = end + 1;
+	}
+	return true;
+}
+
+NicknameRegistry::NicknameRegistry(const std::string& localNode) : localNode(localNode)
+{
+}
+
+NicknameEntry NicknameRegistry::Claim(const std::string& nickname)
+{
+	NicknameEntry& entry = entries[nickname];
+	entry.owner = localNode;
+	entry.version = ++clock;
+	entry.released = false;
+	return entry;
+}
+
+NicknameEntry NicknameRegistry::Release(const std::string& nickname)
+{
+	NicknameEntry& entry = entries[nickname];
+	entry.owner = localNode;
+	entry.version = ++clock;
+	entry.released = true;
+	return entry;
+}
+
+bool NicknameRegistry::Merge(const std::string& nickname, const NicknameEntry& incoming, bool& lostLocal)
+{
+	lostLocal = false;
+	clock = std::max(clock, incoming.version);
+
+	auto it = entries.find(nickname);
+	if (it != entries.end() && !Supersedes(incoming, it->second))
+		return false;
+
+	bool heldLocally = it != entries.end() && it->second.owner == localNode && !it->second.released;
+	if (heldLocally && (incoming.released || incoming.owner == localNode))
+	{
+		// A release (e.g. from before this node restarted with a reset clock) must not free a nickname a
+		// local user still holds: claim it again, newer than anything seen so far
+		it->second.version = ++clock;
+		return true;
+	}
+	NicknameEntry& entry = it != entries.end() ? it->second : entries[nickname];
+	lostLocal = heldLocally && !incoming.released;
+	entry = incoming;
+	// An old claim of our own (e.g. from before a restart) for a nickname no local user holds: answer it
+	// with a newer release instead of passing on a claim nobody backs
+	if (incoming.owner == localNode && !incoming.released)
+	{
+		entry.version = ++clock;
+		entry.released = true;
+	}
+	return true;
+}
+
+void NicknameRegistry::ForgetOwner(const std::string& node)
+{
+	for (auto it = entries.begin(); it != entries.end();)
+	{
+		if (it->second.owner == node)
+			it = entries.erase(it);
+		else
+			++it;
+	}
+}
+
+const NicknameEntry* NicknameRegistry::Find(const std::string& nickname) const
+{
+	auto it = entries.find(nickname);
+	return it == entries.end() ? nullptr : &it->second;
+}
+
+FederationBus::FederationBus(const FederationOptions& options)
+	: options(options), registry(options.nodeId)
+{
+	auto now = std::chrono::steady_clock::now();
+	for (const PeerAddress& address : options.peers)
+	{
+		PeerSlot slot;
+		slot.address = address;
+		slot.nextDial = now;
+		peers.push_back(slot);
+	}
+}
+
+FederationBus::~FederationBus()
+{
+	for (auto& link : links)
+	{
+		if (!link->closed)
+			closesocket(link->sock);
+	}
+	if (listenSocket != INVALID_SOCKET)
+		closesocket(listenSocket);
+}
+
+bool FederationBus::Start()
+{
+	if (options.peerPort == 0)
+		return true;
+
+	socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (sock == INVALID_SOCKET)
+	{
+		printf("Federation socket creation failed: %d\n", SocketLastError());
+		return false;
+	}
+	int opt = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt));
+
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = INADDR_ANY;
+	address.sin_port = htons(options.peerPort);
+	if (bind(sock, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+		listen(sock, SOMAXCONN) == SOCKET_ERROR ||
+		!SetSocketNonBlocking(sock))
+	{
+		printf("Federation port %d could not be opened: %d\n", options.peerPort, SocketLastError());
+		closesocket(sock);
+		return false;
+	}
+
+	listenSocket = sock;
+	printf("Node '%s' accepting peer links on port %d...\n", options.nodeId.c_str(), options.peerPort);
+	return true;
+}
+
+size_t FederationBus::LinkCount() const
+{
+	size_t count = 0;
+	for (const auto& link : links)
+	{
+		if (link->established && !link->closed)
+			count++;
+	}
+	return count;
+}
+
+FederationBus::PeerLink* FederationBus::AddLink(socket_t sock, int peerIndex, bool connecting)
+{
+	std::unique_ptr<PeerLink> link(new PeerLink());
+	link->sock = sock;
+	link->peerIndex = peerIndex;
+	link->connecting = connecting;
+	int opt = 1;
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&opt, sizeof(opt));
+	// The handshake goes out as soon as the socket is writable
+	QueueFrame(link.get(), EncodeHello(options.nodeId));
+	links.push_back(std::move(link));
+	return links.back().get();
+}
+
+void FederationBus::Dial(int peerIndex)
+{
+	PeerSlot& slot = peers[peerIndex];
+	slot.nextDial = std::chrono::steady_clock::now() + std::chrono::seconds(PEER_RECONNECT_SECONDS);
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	struct addrinfo* result = nullptr;
+	std::string port = std::to_string(slot.address.port);
+	if (getaddrinfo(slot.address.host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr)
+		return;
+
+	socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (sock == INVALID_SOCKET || !SetSocketNonBlocking(sock))
+	{
+		if (sock != INVALID_SOCKET)
+			closesocket(sock);
+		freeaddrinfo(result);
+		return;
+	}
+
+	bool connecting = false;
+	if (connect(sock, result->ai_addr, (int)result->ai_addrlen) == SOCKET_ERROR)
+	{
+		if (!SocketConnectPending(SocketLastError()))
+		{
+			closesocket(sock);
+			freeaddrinfo(result);
+			return;
+		}
+		connecting = true;
+	}
+	freeaddrinfo(result);
+	slot.link = AddLink(sock, peerIndex, connecting);
+}
+
+void FederationBus::CloseLink(PeerLink* link)
+{
+	if (link->closed)
+		return;
+	closesocket(link->sock);
+	link->closed = true;
+	if (link->peerIndex >= 0 && peers[link->peerIndex].link == link)
+		peers[link->peerIndex].link = nullptr;
+	if (link->established)
+		generation++;
+	if (link->established && !IsNodeReachable(link->remoteNode))
+		printf("Lost link to node '%s'\n", link->remoteNode.c_str());
+}
+
+void FederationBus::RemoveClosedLinks()
+{
+	links.erase(std::remove_if(links.begin(), links.end(),
+							   [](const std::unique_ptr<PeerLink>& link) { return link->closed; }),
+				links.end());
+}
+
+FederationBus::PeerLink* FederationBus::FindEstablished(const std::string& node, const PeerLink* except) const
+{
+	for (const auto& link : links)
+	{
+		if (link.get() != except && link->established && !link->closed && link->remoteNode == node)
+			return link.get();
+	}
+	return nullptr;
+}
+
+bool FederationBus::IsNodeReachable(const std::string& node) const
+{
+	return FindEstablished(node, nullptr) != nullptr;
+}
+
+void FederationBus::PrepareSelect(fd_set& readfds, fd_set& writefds, int& maxSD)
+{
+	RemoveClosedLinks();
+
+	auto now = std::chrono::steady_clock::now();
+	for (int i = 0; i < (int)peers.size(); i++)
+	{
+		PeerSlot& slot = peers[i];
+		if (slot.link != nullptr || now < slot.nextDial)
+			continue;
+		// Already linked through a connection the other side dialed
+		if (!slot.remoteNode.empty() && IsNodeReachable(slot.remoteNode))
+			continue;
+		Dial(i);
+	}
+
+	if (listenSocket != INVALID_SOCKET)
+	{
+		FD_SET(listenSocket, &readfds);
+		maxSD = std::max(maxSD, (int)listenSocket);
+	}
+	for (const auto& link : links)
+	{
+		if (link->closed)
+			continue;
+		if (!link->connecting)
+			FD_SET(link->sock, &readfds);
+		if (link->connecting || link->outboxOffset < link->outbox.size())
+			FD_SET(link->sock, &writefds);
+		maxSD = std::max(maxSD, (int)link->sock);
+	}
+}
+
+void FederationBus::ProcessSelect(const fd_set& readfds, const fd_set& writefds, std::vector<FederationEvent>& events)
+{
+	if (listenSocket != INVALID_SOCKET && FD_ISSET(listenSocket, &readfds))
+	{
+		while (true)
+		{
+			socket_t sock = accept(listenSocket, nullptr, nullptr);
+			if (sock == INVALID_SOCKET)
+				break;
+			if (!SetSocketNonBlocking(sock))
+			{
+				closesocket(sock);
+				continue;
+			}
+			AddLink(sock, -1, false);
+		}
+	}
+
+	// Links may be appended while frames are handled, so walk by index
+	for (size_t i = 0; i < links.size(); i++)
+	{
+		PeerLink* link = links[i].get();
+		if (link->closed)
+			continue;
+		if (link->connecting)
+		{
+			if (!FD_ISSET(link->sock, &writefds))
+				continue;
+			int error = 0;
+			socklen_t length = sizeof(error);
+			if (getsockopt(link->sock, SOL_SOCKET, SO_ERROR, (char*)&error, &length) != 0 || error != 0)
+			{
+				CloseLink(link);
+				continue;
+			}
+			link->connecting = false;
+		}
+		if (FD_ISSET(link->sock, &readfds))
+			ReadLink(link, events);
+		if (!link->closed && FD_ISSET(link->sock, &writefds))
+			FlushLink(link);
+	}
+}
+
+void FederationBus::ReadLink(PeerLink* link, std::vector<FederationEvent>& events)
+{
+	char buffer[LINK_READ_CHUNK];
+	while (!link->closed)
+	{
+		int valueRead = recv(link->sock, buffer, sizeof(buffer), 0);
+		if (valueRead < 0 && SocketWouldBlock(SocketLastError()))
+			break;
+		if (valueRead <= 0)
+		{
+			CloseLink(link);
+			return;
+		}
+		link->reader.Feed(buffer, (size_t)valueRead);
+
+		std::string payload;
+		while (!link->closed && link->reader.Next(payload))
+			HandleFrame(link, payload, events);
+		if (link->reader.HasError())
+		{
+			printf("Oversized frame from node '%s', dropping link\n", link->remoteNode.c_str());
+			CloseLink(link);
+			return;
+		}
+		if (valueRead < (int)sizeof(buffer))
+			break;
+	}
+}
+
+void FederationBus::HandleFrame(PeerLink* link, const std::string& payload, std::vector<FederationEvent>& events)
+{
+	if (payload.empty())
+		return;
+
+	unsigned char type = (unsigned char)payload[0];
+	FieldReader reader(payload, 1);
+
+	if (type == FRAME_HELLO)
+	{
+		std::string remoteNode = reader.String();
+		if (!reader.ok || remoteNode.empty() || link->established)
+		{
+			CloseLink(link);
+			return;
+		}
+		HandleHello(link, remoteNode);
+		return;
+	}
+
+	// Nothing but the handshake is accepted before the other side identified itself
+	if (!link->established)
+	{
+		CloseLink(link);
+		return;
+	}
+
+	if (type == FRAME_CHAT)
+	{
+		FederationEvent event;
+		event.type = FederationEvent::RemoteChat;
+		event.origin = reader.String();
+		event.text = reader.Rest();
+		if (reader.ok)
+			events.push_back(event);
+	}
+	else if (type == FRAME_NICKNAME)
+	{
+		std::string nickname = reader.String();
+		NicknameEntry entry;
+		entry.owner = reader.String();
+		entry.version = reader.Version();
+		entry.released = reader.Byte() != 0;
+		if (!reader.ok || nickname.empty() || entry.owner.empty())
+			return;
+
+		bool lostLocal = false;
+		if (registry.Merge(nickname, entry, lostLocal))
+		{
+			generation++;
+			const NicknameEntry* merged = registry.Find(nickname);
+			if (merged->owner != entry.owner || merged->version != entry.version || merged->released != entry.released)
+			{
+				// The merge answered the entry with a newer one of ours; everybody, the sender included, needs it
+				Broadcast(EncodeNickname(nickname, *merged), nullptr);
+				return;
+			}
+			// Gossip the change onwards; nodes that already have it will not pass it on again
+			Broadcast(payload, link);
+			if (lostLocal)
+			{
+				FederationEvent event;
+				event.type = FederationEvent::NicknameLost;
+				event.origin = entry.owner;
+				event.text = nickname;
+				events.push_back(event);
+			}
+		}
+	}
+}
+
+void FederationBus::HandleHello(PeerLink* link, const std::string& remoteNode)
+{
+	if (remoteNode == options.nodeId)
+	{
+		printf("Peer link loops back to this node, closing it\n");
+		CloseLink(link);
+		return;
+	}
+	if (link->peerIndex >= 0)
+		peers[link->peerIndex].remoteNode = remoteNode;
+
+	// Both nodes may have dialed each other; keep the link opened by the smaller node id on both sides
+	PeerLink* existing = FindEstablished(remoteNode, link);
+	if (existing != nullptr)
+	{
+		const std::string& preferred = std::min(options.nodeId, remoteNode);
+		bool newPreferred = (link->peerIndex >= 0 ? options.nodeId : remoteNode) == preferred;
+		bool oldPreferred = (existing->peerIndex >= 0 ? options.nodeId : remoteNode) == preferred;
+		if (oldPreferred && !newPreferred)
+		{
+			CloseLink(link);
+			return;
+		}
+		link->remoteNode = remoteNode;
+		link->established = true;
+		CloseLink(existing);
+	}
+	else
+	{
+		printf("Linked to node '%s'\n", remoteNode.c_str());
+		// The node may have restarted; its snapshot below replaces whatever we remembered of it
+		registry.ForgetOwner(remoteNode);
+		link->remoteNode = remoteNode;
+		link->established = true;
+	}
+	generation++;
+
+	for (const auto& pair : registry.Entries())
+		QueueFrame(link, EncodeNickname(pair.first, pair.second));
+}
+
+void FederationBus::QueueFrame(PeerLink* link, const std::string& payload)
+{
+	if (link->closed)
+		return;
+	if (link->outbox.size() - link->outboxOffset > MAX_LINK_BACKLOG)
+	{
+		printf("Node '%s' is not keeping up, dropping link\n", link->remoteNode.c_str());
+		CloseLink(link);
+		return;
+	}
+	AppendFrame(link->outbox, payload.data(), payload.size());
+}
+
+void FederationBus::Broadcast(const std::string& payload, const PeerLink* except)
+{
+	for (const auto& link : links)
+	{
+		if (link.get() != except && link->established && !link->closed)
+			QueueFrame(link.get(), payload);
+	}
+}
+
+void FederationBus::FlushLink(PeerLink* link)
+{
+	while (!link->closed && !link->connecting && link->outboxOffset < link->outbox.size())
+	{
+		size_t remaining = link->outbox.size() - link->outboxOffset;
+		int sent = send(link->sock, link->outbox.data() + link->outboxOffset,
+						(int)std::min(remaining, (size_t)0x7FFFFFFF), SOCKET_SEND_FLAGS);
+		if (sent == SOCKET_ERROR)
+		{
+			if (!SocketWouldBlock(SocketLastError()))
+				CloseLink(link);
+			return;
+		}
+		link->outboxOffset += (size_t)sent;
+	}
+	if (link->outboxOffset == link->outbox.size())
+	{
+		link->outbox.clear();
+		link->outboxOffset = 0;
+	}
+}
+
+void FederationBus::Flush()
+{
+	for (const auto& link : links)
+		FlushLink(link.get());
+}
+
+void FederationBus::PublishChat(const char* text, size_t length)
+{
+	if (length > MaxChatLength())
+	{
+		printf("Chat line of %zu bytes is too long to forward to other nodes, not forwarded\n", length);
+		return;
+	}
+	std::string payload(1, (char)FRAME_CHAT);
+	PutString(payload, options.nodeId);
+	payload.append(text, length);
+	Broadcast(payload, nullptr);
+}
+
+size_t FederationBus::MaxChatLength() const
+{
+	// Type byte, then the node id as a string field
+	return MAX_FRAME_SIZE - 1 - 2 - std::min(options.nodeId.size(), (size_t)0xFFFF);
+}
+
+void FederationBus::ClaimNickname(const std::string& nickname)
+{
+	Broadcast(EncodeNickname(nickname, registry.Claim(nickname)), nullptr);
+	generation++;
+}
+
+void FederationBus::ReleaseNickname(const std::string& nickname)
+{
+	Broadcast(EncodeNickname(nickname, registry.Release(nickname)), nullptr);
+	generation++;
+}
+
+bool FederationBus::IsNicknameTakenRemotely(const std::string& nickname) const
+{
+	const NicknameEntry* entry = registry.Find(nickname);
+	return entry != nullptr && !entry->released && entry->owner != options.nodeId &&
+		   IsNodeReachable(entry->owner);
+}
+
+std::vector<std::pair<std::string, std::string>> FederationBus::RemoteUsers() const
+{
+	std::vector<std::pair<std::string, std::string>> users;
+	for (const auto& pair : registry.Entries())
+	{
+		const NicknameEntry& entry = pair.second;
+		if (!entry.released && entry.owner != options.nodeId && IsNodeReachable(entry.owner))
+			users.push_back(std::make_pair(pair.first, entry.owner));
+	}
+	return users;
+}
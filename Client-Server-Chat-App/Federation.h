@@ -0,0 +1,251 @@
+#pragma once
+/**
+ * @file Federation.h
+ * @brief Inter-node relay bus that lets several chat servers act as one cluster.
+ *
+ * Every server node accepts peer links on its own peer port and dials the peers
+ * it was configured with. Links are persistent TCP connections carrying
+ * length-prefixed frames (see Framing.h); frames produced while one pass of the
+ * server loop runs are queued per link and written together by Flush().
+ *
+ * Chat lines typed by local users are forwarded to every linked node, which
+ * broadcasts them to its own clients. The cluster is expected to be a full mesh
+ * (every node linked to every other), because chat is not re-forwarded.
+ *
+ * Nicknames live in a gossiped registry: each claim or release carries a
+ * Lamport version and the owning node, the newest version wins (ties go to the
+ * smaller node id), and any entry that changes the local registry is passed on
+ * to the other links. A node is authoritative for its own claims, so entries of
+ * a node are only honoured while a link to that node is up.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "SocketCompat.h"
+#include "Framing.h"
+
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Delay before re-dialing a peer whose link went down, in seconds
+#define PEER_RECONNECT_SECONDS 2
+
+// Unsent bytes allowed on one link before the peer is considered stuck and dropped
+#define MAX_LINK_BACKLOG (8 * 1024 * 1024)
+
+/**
+ * @brief Address of a peer node's federation port.
+ */
+struct PeerAddress
+{
+	std::string host;
+	unsigned short port = 0;
+};
+
+/**
+ * @brief Federation settings of one server node.
+ */
+struct FederationOptions
+{
+	std::string nodeId;             // Name of this node, unique within the cluster
+	unsigned short peerPort = 0;    // Port accepting links from other nodes, 0 runs standalone
+	std::vector<PeerAddress> peers; // Nodes this node dials
+};
+
+/**
+ * @brief Parses a comma-separated "host:port" list.
+ * @return false if any entry is malformed.
+ */
+bool ParsePeerList(const std::string& text, std::vector<PeerAddress>& peers);
+
+/**
+ * @brief Current owner of a nickname as known by one node.
+ */
+struct NicknameEntry
+{
+	std::string owner;    // Node that made the latest claim or release
+	uint64_t version = 0; // Lamport timestamp of that change
+	bool released = false;
+};
+
+/**
+ * @brief Last-writer-wins nickname registry shared by gossip.
+ */
+class NicknameRegistry
+{
+public:
+	explicit NicknameRegistry(const std::string& localNode);
+
+	/**
+	 * @brief Records a claim made on this node and returns the new entry.
+	 */
+	NicknameEntry Claim(const std::string& nickname);
+
+	/**
+	 * @brief Records a release made on this node and returns the new entry.
+	 */
+	NicknameEntry Release(const std::string& nickname);
+
+	/**
+	 * @brief Merges an entry received from another node.
+	 *
+	 * A release (or a stale claim of this node) never frees a nickname a local
+	 * user holds: the local claim is renewed with a newer version instead. A
+	 * stale claim of this node for a nickname it does not hold is answered with
+	 * a newer release. In both cases the stored entry differs from incoming and
+	 * must be sent to every link.
+	 *
+	 * @param lostLocal Set to true if a local claim was overruled by another node's claim.
+	 * @return true if the registry changed and the stored entry should be passed on.
+	 */
+	bool Merge(const std::string& nickname, const NicknameEntry& incoming, bool& lostLocal);
+
+	/**
+	 * @brief Forgets every entry owned by the given node.
+	 */
+	void ForgetOwner(const std::string& node);
+
+	const NicknameEntry* Find(const std::string& nickname) const;
+
+	const std::map<std::string, NicknameEntry>& Entries() const { return entries; }
+
+private:
+	std::string localNode;
+	uint64_t clock = 0;
+	std::map<std::string, NicknameEntry> entries;
+};
+
+/**
+ * @brief Something the server loop has to act on after ProcessSelect().
+ */
+struct FederationEvent
+{
+	enum Type
+	{
+		RemoteChat,    // text is a chat line typed on another node
+		NicknameLost   // text is a local nickname now owned by another node
+	};
+
+	Type type;
+	std::string origin; // Node the event came from
+	std::string text;
+};
+
+/**
+ * @brief Peer links, frame batching and the nickname registry of one node.
+ *
+ * Not thread-safe: the bus is meant to be driven from the server's select() loop.
+ */
+class FederationBus
+{
+public:
+	explicit FederationBus(const FederationOptions& options);
+	~FederationBus();
+
+	FederationBus(const FederationBus&) = delete;
+	FederationBus& operator=(const FederationBus&) = delete;
+
+	/**
+	 * @brief Opens the peer port. Does nothing for a standalone node.
+	 * @return false if the peer port could not be opened.
+	 */
+	bool Start();
+
+	// True once Start() opened the peer port
+	bool IsEnabled() const { return listenSocket != INVALID_SOCKET; }
+
+	const std::string& NodeId() const { return options.nodeId; }
+
+	// Number of links that completed the handshake
+	size_t LinkCount() const;
+
+	/**
+	 * @brief Dials peers that are due and adds the bus sockets to the select() sets.
+	 */
+	void PrepareSelect(fd_set& readfds, fd_set& writefds, int& maxSD);
+
+	/**
+	 * @brief Accepts links, reads frames and finishes pending connects.
+	 */
+	void ProcessSelect(const fd_set& readfds, const fd_set& writefds, std::vector<FederationEvent>& events);
+
+	/**
+	 * @brief Writes every queued frame, one send() per link.
+	 */
+	void Flush();
+
+	/**
+	 * @brief Queues a local chat line for every linked node.
+	 *
+	 * A line longer than MaxChatLength() is not forwarded (a peer would take the
+	 * frame for a protocol error and drop the link); the reason is printed.
+	 */
+	void PublishChat(const char* text, size_t length);
+
+	// Longest chat line that fits in one frame together with the CHAT header and this node's id
+	size_t MaxChatLength() const;
+
+	void ClaimNickname(const std::string& nickname);
+	void ReleaseNickname(const std::string& nickname);
+
+	/**
+	 * @brief True if a reachable node other than this one holds the nickname.
+	 */
+	bool IsNicknameTakenRemotely(const std::string& nickname) const;
+
+	/**
+	 * @brief Nicknames held on reachable remote nodes, as (nickname, node) pairs.
+	 */
+	std::vector<std::pair<std::string, std::string>> RemoteUsers() const;
+
+	// Changes whenever the result of RemoteUsers() may have changed
+	uint64_t Generation() const { return generation; }
+
+private:
+	struct PeerLink
+	{
+		socket_t sock = INVALID_SOCKET;
+		int peerIndex = -1;        // Index in peers for links we dialed, -1 for accepted ones
+		bool connecting = false;   // Non-blocking connect() still in flight
+		bool established = false;  // HELLO received from the other side
+		bool closed = false;
+		std::string remoteNode;
+		FrameReader reader;
+		std::string outbox;        // Encoded frames not yet written
+		size_t outboxOffset = 0;
+	};
+
+	struct PeerSlot
+	{
+		PeerAddress address;
+		PeerLink* link = nullptr;
+		std::string remoteNode; // Learned from the HELLO of an earlier link
+		std::chrono::steady_clock::time_point nextDial;
+	};
+
+	PeerLink* AddLink(socket_t sock, int peerIndex, bool connecting);
+	void Dial(int peerIndex);
+	void CloseLink(PeerLink* link);
+	void RemoveClosedLinks();
+	void ReadLink(PeerLink* link, std::vector<FederationEvent>& events);
+	void FlushLink(PeerLink* link);
+	void QueueFrame(PeerLink* link, const std::string& payload);
+	void Broadcast(const std::string& payload, const PeerLink* except);
+	void HandleFrame(PeerLink* link, const std::string& payload, std::vector<FederationEvent>& events);
+	void HandleHello(PeerLink* link, const std::string& remoteNode);
+	PeerLink* FindEstablished(const std::string& node, const PeerLink* except) const;
+	bool IsNodeReachable(const std::string& node) const;
+
+	FederationOptions options;
+	socket_t listenSocket = INVALID_SOCKET;
+	std::vector<PeerSlot> peers;
+	std::vector<std::unique_ptr<PeerLink>> links;
+	NicknameRegistry registry;
+	uint64_t generation = 0;
+};
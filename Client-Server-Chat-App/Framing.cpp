@@ -0,0 +1,57 @@
+/**
+ * @file Framing.cpp
+ * @brief Implementation of the length-prefixed frame codec.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Framing.h"
+
+void AppendFrame(std::string& out, const char* payload, size_t length)
+{
+	char header[FRAME_HEADER_SIZE];
+	header[0] = (char)((length >> 24) & 0xFF);
+	header[1] = (char)((length >> 16) & 0xFF);
+	header[2] = (char)((length >> 8) & 0xFF);
+	header[3] = (char)(length & 0xFF);
+	out.append(header, FRAME_HEADER_SIZE);
+	out.append(payload, length);
+}
+
+void FrameReader::Feed(const char* data, size_t length)
+{
+	// Drop the consumed prefix before growing the buffer so it does not creep forever
+	if (offset > 0 && offset == pending.size())
+	{
+		pending.clear();
+		offset = 0;
+	}
+	else if (offset > MAX_FRAME_SIZE)
+	{
+		pending.erase(0, offset);
+		offset = 0;
+	}
+	pending.append(data, length);
+}
+
+bool FrameReader::Next(std::string& payload)
+{
+	if (error || pending.size() - offset < FRAME_HEADER_SIZE)
+		return false;
+
+	const unsigned char* header = (const unsigned char*)pending.data() + offset;
+	size_t length = ((size_t)header[0] << 24) | ((size_t)header[1] << 16) |
+					((size_t)header[2] << 8) | (size_t)header[3];
+	if (length > MAX_FRAME_SIZE)
+	{
+		error = true;
+		return false;
+	}
+	if (pending.size() - offset - FRAME_HEADER_SIZE < length)
+		return false;
+
+	payload.assign(pending, offset + FRAME_HEADER_SIZE, length);
+	offset += FRAME_HEADER_SIZE + length;
+	return true;
+}
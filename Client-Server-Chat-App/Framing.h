@@ -0,0 +1,65 @@
+#pragma once
+/**
+ * @file Framing.h
+ * @brief Length-prefixed framing for messages carried over a TCP stream.
+ *
+ * TCP does not preserve message boundaries, so every frame on the wire is a
+ * 4-byte big-endian payload length followed by the payload itself.
+ * FrameReader accumulates received bytes and hands back complete payloads.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Size of the length prefix in front of every frame
+#define FRAME_HEADER_SIZE 4
+
+// Largest payload accepted from a peer; anything bigger is treated as a protocol error
+#define MAX_FRAME_SIZE 65536
+
+// Longest nickname "/nick" accepts
+#define MAX_NICKNAME_LENGTH 32
+
+// First byte of server-only control frames; the server refuses client lines that start with it
+#define CONTROL_FRAME_PREFIX "\001"
+
+// Control frame answering a successful "/nick", followed by the nickname; the client switches names on it
+#define NICKNAME_CONFIRMATION_PREFIX CONTROL_FRAME_PREFIX "nick "
+
+/**
+ * @brief Appends one encoded frame (header + payload) to the end of out.
+ */
+void AppendFrame(std::string& out, const char* payload, size_t length);
+
+/**
+ * @brief Incremental decoder for a stream of length-prefixed frames.
+ */
+class FrameReader
+{
+public:
+	/**
+	 * @brief Appends raw bytes read from the stream.
+	 */
+	void Feed(const char* data, size_t length);
+
+	/**
+	 * @brief Extracts the next complete frame.
+	 * @param payload Receives the frame payload.
+	 * @return true if a frame was extracted, false if more bytes are needed or the stream is corrupt.
+	 */
+	bool Next(std::string& payload);
+
+	/**
+	 * @brief Returns true once an oversized frame header has been seen.
+	 */
+	bool HasError() const { return error; }
+
+private:
+	std::string pending; // Received bytes not yet consumed
+	size_t offset = 0;   // Start of the first unconsumed byte in pending
+	bool error = false;
+};
@@ -0,0 +1,626 @@
+/**
+ * @file OfflineQueue.cpp
+ * @brief Segmented append-only log behind the offline message queues.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "OfflineQueue.h"
+#include "Framing.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <iterator>
+
+#ifdef _WIN32
+#include <direct.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// Record types, see OfflineQueue.h
+#define RECORD_TRACK 1
+#define RECORD_MESSAGE 2
+#define RECORD_DROP 3
+#define RECORD_DELIVER 4
+
+// Type, sequence number and nickname length in front of the nickname and the text
+#define RECORD_HEADER_SIZE 10
+
+// Longest nickname a record can hold
+#define MAX_RECORD_NICKNAME 255
+
+// stdio buffer of the active segment
+#define SEGMENT_WRITE_BUFFER (64 * 1024)
+
+namespace
+{
+	bool MakeDirectory(const std::string& path)
+	{
+#ifdef _WIN32
+		int result = _mkdir(path.c_str());
+#else
+		int result = mkdir(path.c_str(), 0755);
+#endif
+		return result == 0 || errno == EEXIST;
+	}
+
+	// Numbers of the segment files found in a directory
+	std::vector<uint32_t> ListSegments(const std::string& directory)
+	{
+		std::vector<uint32_t> found;
+		unsigned int segment = 0;
+		char extra = 0;
+#ifdef _WIN32
+		WIN32_FIND_DATAA entry;
+		HANDLE search = FindFirstFileA((directory + "\\segment-*.log").c_str(), &entry);
+		if (search != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				if (sscanf_s(entry.cFileName, "segment-%u.lo%c", &segment, &extra, 1) == 2 && extra == 'g')
+					found.push_back(segment);
+			} while (FindNextFileA(search, &entry));
+			FindClose(search);
+		}
+#else
+		DIR* dir = opendir(directory.c_str());
+		if (dir != nullptr)
+		{
+			while (struct dirent* entry = readdir(dir))
+			{
+				if (sscanf(entry->d_name, "segment-%u.lo%c", &segment, &extra) == 2 && extra == 'g')
+					found.push_back(segment);
+			}
+			closedir(dir);
+		}
+#endif
+		std::sort(found.begin(), found.end());
+		return found;
+	}
+
+	bool ReadFile(const std::string& path, long offset, size_t length, std::string& data)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+			return false;
+		data.resize(length);
+		bool ok = fseek(file, offset, SEEK_SET) == 0 &&
+				  (length == 0 || fread(&data[0], 1, length, file) == length);
+		fclose(file);
+		return ok;
+	}
+
+	long FileSize(const std::string& path)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+			return -1;
+		long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+		fclose(file);
+		return size;
+	}
+
+	uint32_t ReadBigEndian32(const char* data)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+	}
+
+	int64_t NowSeconds()
+	{
+		return (int64_t)time(nullptr);
+	}
+}
+
+OfflineStore::OfflineStore(const OfflineOptions& options)
+	: options(options)
+{
+}
+
+OfflineStore::~OfflineStore()
+{
+	if (activeFile != nullptr)
+		fclose(activeFile);
+}
+
+std::string OfflineStore::SegmentPath(uint32_t segment) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "segment-%08u.log", (unsigned int)segment);
+	return options.directory + "/" + name;
+}
+
+bool OfflineStore::Open()
+{
+	if (!MakeDirectory(options.directory))
+	{
+		printf("Could not create offline queue directory '%s'\n", options.directory.c_str());
+		return false;
+	}
+	for (uint32_t segment : ListSegments(options.directory))
+	{
+		Replay(segment);
+	}
+	// Replay keeps the watermarks of every nickname it saw; only tracked ones or pending lines matter now
+	for (auto it = recipients.begin(); it != recipients.end();)
+	{
+		if (!it->second.tracked)
+			Forget(it->second, UINT64_MAX);
+		it->second.consumedUpTo = 0;
+		if (!it->second.tracked)
+			it = recipients.erase(it);
+		else
+			++it;
+	}
+	// The last segment may end in a torn record, so appends always go to a fresh one
+	if (!StartSegment())
+		return false;
+	// The limits may have been lowered since the segments were written
+	ExpireIdle(NowSeconds());
+	size_t tracked = recipients.size();
+	while (options.maxRecipients > 0 && tracked > options.maxRecipients)
+	{
+		auto oldest = recipients.end();
+		for (auto it = recipients.begin(); it != recipients.end(); ++it)
+		{
+			if (oldest == recipients.end() || it->second.trackedSince < oldest->second.trackedSince)
+				oldest = it;
+		}
+		Untrack(oldest);
+		tracked--;
+	}
+	CompactIfNeeded();
+	return true;
+}
+
+bool OfflineStore::StartSegment()
+{
+	activeSegment = segments.empty() ? 1 : segments.rbegin()->first + 1;
+	std::string path = SegmentPath(activeSegment);
+	activeFile = fopen(path.c_str(), "wb");
+	if (activeFile == nullptr)
+	{
+		printf("Could not create offline queue segment '%s'\n", path.c_str());
+		return false;
+	}
+	setvbuf(activeFile, nullptr, _IOFBF, SEGMENT_WRITE_BUFFER);
+	segments[activeSegment] = Segment();
+	return true;
+}
+
+void OfflineStore::Replay(uint32_t segment)
+{
+	std::string path = SegmentPath(segment);
+	long size = FileSize(path);
+	std::string data;
+	if (size < 0 || !ReadFile(path, 0, (size_t)size, data))
+	{
+		printf("Could not read offline queue segment '%s'\n", path.c_str());
+		return;
+	}
+	segments[segment].bytes = data.size();
+
+	size_t offset = 0;
+	while (offset + FRAME_HEADER_SIZE <= data.size())
+	{
+		uint32_t length = ReadBigEndian32(data.data() + offset);
+		// A torn write at the end of the file; everything before it is intact
+		if (length > MAX_FRAME_SIZE || offset + FRAME_HEADER_SIZE + length > data.size())
+			break;
+		ApplyRecord(segment, (long)offset, data.data() + offset + FRAME_HEADER_SIZE, length);
+		offset += FRAME_HEADER_SIZE + length;
+	}
+}
+
+void OfflineStore::ApplyRecord(uint32_t segment, long recordOffset, const char* payload, size_t length)
+{
+	if (length < RECORD_HEADER_SIZE)
+		return;
+	uint8_t type = (uint8_t)payload[0];
+	uint64_t sequence = ((uint64_t)ReadBigEndian32(payload + 1) << 32) | ReadBigEndian32(payload + 5);
+	size_t nicknameLength = (unsigned char)payload[9];
+	if (length < RECORD_HEADER_SIZE + nicknameLength)
+		return;
+	std::string nickname(payload + RECORD_HEADER_SIZE, nicknameLength);
+	nextSequence = std::max(nextSequence, sequence + 1);
+
+	Recipient& recipient = recipients[nickname];
+	switch (type)
+	{
+	case RECORD_TRACK:
+		recipient.tracked = true;
+		// Records written before the time was stored count from now
+		recipient.trackedSince = length >= RECORD_HEADER_SIZE + nicknameLength + 8
+			? (int64_t)(((uint64_t)ReadBigEndian32(payload + RECORD_HEADER_SIZE + nicknameLength) << 32) |
+						ReadBigEndian32(payload + RECORD_HEADER_SIZE + nicknameLength + 4))
+			: NowSeconds();
+		break;
+	case RECORD_MESSAGE:
+	{
+		// Compaction interrupted by a crash leaves a line in two segments; the first copy wins
+		if (sequence <= recipient.consumedUpTo || recipient.lines.count(sequence) != 0)
+			break;
+		PendingLine line;
+		line.segment = segment;
+		line.offset = recordOffset + FRAME_HEADER_SIZE + RECORD_HEADER_SIZE + (long)nicknameLength;
+		line.length = (uint32_t)(length - RECORD_HEADER_SIZE - nicknameLength);
+		line.recordSize = (uint32_t)(FRAME_HEADER_SIZE + length);
+		recipient.lines[sequence] = line;
+		recipient.bytes += line.length;
+		segments[segment].liveBytes += line.recordSize;
+		break;
+	}
+	case RECORD_DROP:
+	case RECORD_DELIVER:
+		Forget(recipient, sequence);
+		recipient.consumedUpTo = std::max(recipient.consumedUpTo, sequence);
+		if (type == RECORD_DELIVER)
+			recipient.tracked = false;
+		break;
+	default:
+		break;
+	}
+}
+
+void OfflineStore::AppendRecord(uint8_t type, uint64_t sequence, const std::string& nickname,
+								const char* text, size_t length, PendingLine* line)
+{
+	if (activeFile == nullptr)
+		return;
+	std::string payload;
+	payload.reserve(RECORD_HEADER_SIZE + nickname.size() + length);
+	payload.push_back((char)type);
+	for (int shift = 56; shift >= 0; shift -= 8)
+		payload.push_back((char)((sequence >> shift) & 0xFF));
+	payload.push_back((char)nickname.size());
+	payload += nickname;
+	if (length > 0)
+		payload.append(text, length);
+	std::string record;
+	AppendFrame(record, payload.data(), payload.size());
+
+	Segment& segment = segments[activeSegment];
+	if (fwrite(record.data(), 1, record.size(), activeFile) != record.size())
+	{
+		printf("Could not write to offline queue segment '%s'\n", SegmentPath(activeSegment).c_str());
+		return;
+	}
+	if (line != nullptr)
+	{
+		line->segment = activeSegment;
+		line->offset = (long)(segment.bytes + record.size() - length);
+		line->length = (uint32_t)length;
+		line->recordSize = (uint32_t)record.size();
+	}
+	segment.bytes += record.size();
+	if (segment.bytes >= options.segmentBytes)
+	{
+		fclose(activeFile);
+		activeFile = nullptr;
+		StartSegment();
+	}
+}
+
+void OfflineStore::Track(const std::string& nickname)
+{
+	if (nickname.empty() || nickname.size() > MAX_RECORD_NICKNAME)
+		return;
+	auto existing = recipients.find(nickname);
+	if (existing != recipients.end() && existing->second.tracked)
+		return;
+
+	// Every tracked nickname costs a write per broadcast line: give up on the one away longest
+	if (options.maxRecipients > 0)
+	{
+		size_t tracked = 0;
+		auto oldest = recipients.end();
+		for (auto it = recipients.begin(); it != recipients.end(); ++it)
+		{
+			if (!it->second.tracked)
+				continue;
+			tracked++;
+			if (oldest == recipients.end() || it->second.trackedSince < oldest->second.trackedSince)
+				oldest = it;
+		}
+		if (tracked >= options.maxRecipients)
+			Untrack(oldest);
+	}
+
+	Recipient& recipient = recipients[nickname];
+	recipient.tracked = true;
+	recipient.trackedSince = NowSeconds();
+	AppendTrack(nickname, recipient);
+}
+
+void OfflineStore::AppendTrack(const std::string& nickname, const Recipient& recipient)
+{
+	char since[8];
+	for (int i = 0; i < 8; i++)
+		since[i] = (char)(((uint64_t)recipient.trackedSince >> (56 - 8 * i)) & 0xFF);
+	AppendRecord(RECORD_TRACK, 0, nickname, since, sizeof(since), nullptr);
+}
+
+// Gives up on a tracked nickname: its lines are discarded and nothing more is queued for it
+void OfflineStore::Untrack(std::map<std::string, Recipient>::iterator it)
+{
+	Recipient& recipient = it->second;
+	uint64_t upTo = recipient.lines.empty() ? 0 : recipient.lines.rbegin()->first;
+	stats.dropped += recipient.lines.size();
+	Forget(recipient, upTo);
+	AppendRecord(RECORD_DELIVER, upTo, it->first, nullptr, 0, nullptr);
+	recipients.erase(it);
+	stats.expired++;
+}
+
+void OfflineStore::ExpireIdle(int64_t now)
+{
+	lastExpiryCheck = now;
+	if (options.recipientTtlSeconds == 0)
+		return;
+	for (auto it = recipients.begin(); it != recipients.end();)
+	{
+		auto next = std::next(it);
+		if (it->second.tracked && now - it->second.trackedSince > (int64_t)options.recipientTtlSeconds)
+			Untrack(it);
+		it = next;
+	}
+	CompactIfNeeded();
+}
+
+bool OfflineStore::IsTracked(const std::string& nickname) const
+{
+	auto it = recipients.find(nickname);
+	return it != recipients.end() && it->second.tracked;
+}
+
+size_t OfflineStore::RecipientCount() const
+{
+	return recipients.size();
+}
+
+size_t OfflineStore::PendingCount(const std::string& nickname) const
+{
+	auto it = recipients.find(nickname);
+	return it == recipients.end() ? 0 : it->second.lines.size();
+}
+
+void OfflineStore::EnqueueForAll(const char* message, size_t length)
+{
+	int64_t now = NowSeconds();
+	if (now != lastExpiryCheck)
+		ExpireIdle(now);
+	for (auto& pair : recipients)
+	{
+		if (pair.second.tracked)
+			AppendLine(pair.second, pair.first, nextSequence++, message, length);
+	}
+}
+
+bool OfflineStore::Enqueue(const std::string& nickname, const char* message, size_t length)
+{
+	auto it = recipients.find(nickname);
+	if (it == recipients.end() || !it->second.tracked)
+		return false;
+	AppendLine(it->second, nickname, nextSequence++, message, length);
+	return true;
+}
+
+void OfflineStore::AppendLine(Recipient& recipient, const std::string& nickname, uint64_t sequence,
+							  const char* message, size_t length)
+{
+	if (length > options.maxBytesPerUser || length > MAX_FRAME_SIZE - RECORD_HEADER_SIZE - MAX_RECORD_NICKNAME)
+	{
+		stats.dropped++;
+		return;
+	}
+	// Make room by dropping the oldest lines
+	if (recipient.bytes + length > options.maxBytesPerUser)
+	{
+		uint64_t upTo = 0;
+		size_t freed = 0;
+		for (const auto& pair : recipient.lines)
+		{
+			upTo = pair.first;
+			freed += pair.second.length;
+			stats.dropped++;
+			if (recipient.bytes - freed + length <= options.maxBytesPerUser)
+				break;
+		}
+		Forget(recipient, upTo);
+		AppendRecord(RECORD_DROP, upTo, nickname, nullptr, 0, nullptr);
+	}
+
+	PendingLine line;
+	AppendRecord(RECORD_MESSAGE, sequence, nickname, message, length, &line);
+	if (line.recordSize == 0)
+		return;
+	recipient.lines[sequence] = line;
+	recipient.bytes += length;
+	segments[line.segment].liveBytes += line.recordSize;
+	stats.queued++;
+	CompactIfNeeded();
+}
+
+void OfflineStore::Forget(Recipient& recipient, uint64_t upTo)
+{
+	auto end = recipient.lines.upper_bound(upTo);
+	for (auto it = recipient.lines.begin(); it != end; ++it)
+	{
+		recipient.bytes -= it->second.length;
+		auto segment = segments.find(it->second.segment);
+		if (segment != segments.end())
+			segment->second.liveBytes -= it->second.recordSize;
+	}
+	recipient.lines.erase(recipient.lines.begin(), end);
+}
+
+bool OfflineStore::ReadLines(const std::vector<std::pair<uint64_t, PendingLine>>& lines, std::vector<std::string>& texts)
+{
+	texts.assign(lines.size(), std::string());
+	// One read per segment, covering every line needed from it
+	std::map<uint32_t, std::vector<size_t>> bySegment;
+	for (size_t i = 0; i < lines.size(); i++)
+		bySegment[lines[i].second.segment].push_back(i);
+
+	std::string span;
+	for (const auto& pair : bySegment)
+	{
+		long first = lines[pair.second.front()].second.offset;
+		long last = first;
+		for (size_t i : pair.second)
+		{
+			first = std::min(first, lines[i].second.offset);
+			last = std::max(last, lines[i].second.offset + (long)lines[i].second.length);
+		}
+		if (!ReadFile(SegmentPath(pair.first), first, (size_t)(last - first), span))
+			return false;
+		for (size_t i : pair.second)
+			texts[i].assign(span, (size_t)(lines[i].second.offset - first), lines[i].second.length);
+	}
+	return true;
+}
+
+size_t OfflineStore::Peek(const std::string& nickname, std::string& frames, uint64_t& upTo)
+{
+	upTo = 0;
+	auto it = recipients.find(nickname);
+	if (it == recipients.end())
+		return 0;
+	const Recipient& recipient = it->second;
+
+	// Lines of the active segment may still sit in the stdio buffer
+	Sync();
+	std::vector<std::pair<uint64_t, PendingLine>> lines(recipient.lines.begin(), recipient.lines.end());
+	// Unreadable lines are acknowledged with the rest: offering them again would fail again
+	upTo = lines.empty() ? 0 : lines.back().first;
+	std::vector<std::string> texts;
+	if (!ReadLines(lines, texts))
+	{
+		printf("Could not read the offline messages of '%s'\n", nickname.c_str());
+		return 0;
+	}
+	size_t total = 0;
+	for (const std::string& text : texts)
+		total += FRAME_HEADER_SIZE + text.size();
+	frames.reserve(frames.size() + total);
+	for (const std::string& text : texts)
+		AppendFrame(frames, text.data(), text.size());
+	return texts.size();
+}
+
+void OfflineStore::Acknowledge(const std::string& nickname, uint64_t upTo)
+{
+	auto it = recipients.find(nickname);
+	if (it == recipients.end())
+		return;
+	Recipient& recipient = it->second;
+	size_t count = 0;
+	for (auto line = recipient.lines.begin(); line != recipient.lines.end() && line->first <= upTo; ++line)
+		count++;
+	Forget(recipient, upTo);
+	AppendRecord(RECORD_DELIVER, upTo, nickname, nullptr, 0, nullptr);
+	recipients.erase(it);
+	stats.delivered += count;
+	CompactIfNeeded();
+}
+
+size_t OfflineStore::Drain(const std::string& nickname, std::string& frames)
+{
+	uint64_t upTo = 0;
+	size_t count = Peek(nickname, frames, upTo);
+	Acknowledge(nickname, upTo);
+	return count;
+}
+
+void OfflineStore::Sync()
+{
+	if (activeFile != nullptr)
+		fflush(activeFile);
+}
+
+void OfflineStore::RemoveFiles()
+{
+	if (activeFile != nullptr)
+	{
+		fclose(activeFile);
+		activeFile = nullptr;
+	}
+	for (const auto& pair : segments)
+		remove(SegmentPath(pair.first).c_str());
+	segments.clear();
+	recipients.clear();
+}
+
+void OfflineStore::CompactIfNeeded()
+{
+	if (compacting)
+		return;
+	size_t sealedBytes = 0;
+	size_t sealedLive = 0;
+	for (const auto& pair : segments)
+	{
+		if (pair.first == activeSegment)
+			continue;
+		sealedBytes += pair.second.bytes;
+		sealedLive += pair.second.liveBytes;
+	}
+	if (sealedBytes > 0 && sealedLive * 2 <= sealedBytes)
+		Compact();
+}
+
+void OfflineStore::Compact()
+{
+	compacting = true;
+	stats.compactions++;
+	std::vector<uint32_t> sealed;
+	for (const auto& pair : segments)
+	{
+		if (pair.first != activeSegment)
+			sealed.push_back(pair.first);
+	}
+
+	for (auto& pair : recipients)
+	{
+		Recipient& recipient = pair.second;
+		// The TRACK record of this nickname may be in a segment about to go away
+		if (recipient.tracked)
+			AppendTrack(pair.first, recipient);
+
+		std::vector<std::pair<uint64_t, PendingLine>> moving;
+		for (const auto& line : recipient.lines)
+		{
+			if (std::find(sealed.begin(), sealed.end(), line.second.segment) != sealed.end())
+				moving.push_back(line);
+		}
+		std::vector<std::string> texts;
+		if (moving.empty() || !ReadLines(moving, texts))
+			continue;
+		for (size_t i = 0; i < moving.size(); i++)
+		{
+			PendingLine line;
+			AppendRecord(RECORD_MESSAGE, moving[i].first, pair.first, texts[i].data(), texts[i].size(), &line);
+			if (line.recordSize == 0)
+				continue;
+			recipient.lines[moving[i].first] = line;
+			segments[line.segment].liveBytes += line.recordSize;
+		}
+	}
+
+	// The copies must be on disk before the originals are removed
+	Sync();
+	for (uint32_t segment : sealed)
+	{
+		remove(SegmentPath(segment).c_str());
+		segments.erase(segment);
+	}
+	compacting = false;
+}
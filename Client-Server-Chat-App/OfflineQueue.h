@@ -0,0 +1,210 @@
+#pragma once
+/**
+ * @file OfflineQueue.h
+ * @brief Disk-backed queue of chat lines for users who are currently offline.
+ *
+ * When a client with a nickname disconnects, the nickname becomes a tracked
+ * recipient: every line broadcast while it is away is appended to its queue.
+ * When the nickname comes back, the whole queue is handed over at once as a
+ * block of ready-made frames, so it reaches the client in one burst.
+ *
+ * All queues share one append-only log, split into numbered segment files in
+ * the queue directory. A record is a frame (see Framing.h) whose payload holds
+ * the record type, a sequence number, the recipient and the chat line:
+ *
+ * - TRACK:   start queueing for a nickname (the text holds the time, in
+ *            seconds since the epoch, as 8 big-endian bytes);
+ * - MESSAGE: one queued line;
+ * - DROP:    lines up to a sequence number were discarded to stay within the
+ *            per-user budget;
+ * - DELIVER: lines up to a sequence number were delivered, stop queueing.
+ *            Also written when a nickname is given up on (see below).
+ *
+ * Every broadcast line is written once per tracked nickname, so the number of
+ * tracked nicknames is bounded: a nickname that has been away for longer than
+ * recipientTtlSeconds is given up on, and tracking a new one beyond
+ * maxRecipients gives up on the nickname that has been away longest. The lines
+ * of a nickname given up on are discarded.
+ *
+ * Which lines are still pending is kept in memory and rebuilt by replaying the
+ * segments on start-up. Once at least half of the bytes in the older segments
+ * are dead, the pending lines they still hold are copied to the end of the log
+ * and the old segments are deleted (compaction).
+ *
+ * Writes are buffered; Sync() pushes them to the operating system. Lines are
+ * not fsync'ed, so a power loss may drop the last ones.
+ *
+ * Not thread-safe: the server loop owns the store.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// Default directory holding the log segments
+#define DEFAULT_OFFLINE_DIRECTORY "offline"
+
+// Default cap on the queued bytes of one user; the oldest lines are dropped beyond it
+#define DEFAULT_OFFLINE_BYTES_PER_USER (1024 * 1024)
+
+// Default number of absent nicknames queued for at once; the one away longest is given up on beyond it
+#define DEFAULT_OFFLINE_MAX_RECIPIENTS 128
+
+// Default time a nickname may stay away before its queue is given up on, in seconds (3 days)
+#define DEFAULT_OFFLINE_RECIPIENT_TTL (3 * 24 * 60 * 60)
+
+// Default size at which the log moves on to a new segment file
+#define DEFAULT_OFFLINE_SEGMENT_BYTES (4 * 1024 * 1024)
+
+/**
+ * @brief Tuning of an OfflineStore.
+ */
+struct OfflineOptions
+{
+	std::string directory = DEFAULT_OFFLINE_DIRECTORY;
+	size_t maxBytesPerUser = DEFAULT_OFFLINE_BYTES_PER_USER;
+	size_t maxRecipients = DEFAULT_OFFLINE_MAX_RECIPIENTS;          // 0 for no limit
+	unsigned int recipientTtlSeconds = DEFAULT_OFFLINE_RECIPIENT_TTL; // 0 keeps nicknames forever
+	size_t segmentBytes = DEFAULT_OFFLINE_SEGMENT_BYTES;
+};
+
+/**
+ * @brief Counters for benchmarks and diagnostics.
+ */
+struct OfflineStats
+{
+	unsigned long long queued = 0;      // Lines appended to a queue
+	unsigned long long delivered = 0;   // Lines acknowledged as delivered
+	unsigned long long dropped = 0;     // Lines discarded to respect the per-user budget
+	unsigned long long compactions = 0; // Times the old segments were rewritten
+	unsigned long long expired = 0;     // Nicknames given up on (too long away, or too many)
+};
+
+class OfflineStore
+{
+public:
+	explicit OfflineStore(const OfflineOptions& options = OfflineOptions());
+	~OfflineStore();
+
+	OfflineStore(const OfflineStore&) = delete;
+	OfflineStore& operator=(const OfflineStore&) = delete;
+
+	/**
+	 * @brief Creates the directory if needed, replays the existing segments and starts a new one.
+	 * @return false if the directory or the new segment could not be created; the reason has been printed.
+	 */
+	bool Open();
+
+	/**
+	 * @brief Starts queueing lines for a nickname that went offline. Does nothing if it is already tracked.
+	 *
+	 * With maxRecipients nicknames tracked already, the one away longest is given up on first.
+	 */
+	void Track(const std::string& nickname);
+
+	bool IsTracked(const std::string& nickname) const;
+
+	/**
+	 * @brief Appends a line to the queue of every tracked nickname.
+	 *
+	 * Gives up on nicknames away for longer than recipientTtlSeconds first (checked once a second).
+	 */
+	void EnqueueForAll(const char* message, size_t length);
+
+	/**
+	 * @brief Appends a line to the queue of one tracked nickname.
+	 * @return false if the nickname is not tracked.
+	 */
+	bool Enqueue(const std::string& nickname, const char* message, size_t length);
+
+	// Lines waiting for a nickname
+	size_t PendingCount(const std::string& nickname) const;
+
+	/**
+	 * @brief Reads every line queued for a nickname, leaving them queued.
+	 * @param frames Receives the lines encoded as consecutive frames, oldest first.
+	 * @param upTo Receives the sequence number to pass to Acknowledge() once the lines were handed over.
+	 * @return The number of lines appended to frames.
+	 */
+	size_t Peek(const std::string& nickname, std::string& frames, uint64_t& upTo);
+
+	/**
+	 * @brief Records the lines up to upTo as delivered and stops tracking the nickname.
+	 */
+	void Acknowledge(const std::string& nickname, uint64_t upTo);
+
+	/**
+	 * @brief Peek() and Acknowledge() in one step, for callers whose hand-off cannot fail.
+	 */
+	size_t Drain(const std::string& nickname, std::string& frames);
+
+	/**
+	 * @brief Pushes buffered log writes to the operating system.
+	 */
+	void Sync();
+
+	size_t RecipientCount() const;
+
+	/**
+	 * @brief Closes the log and deletes its segment files, leaving the store empty.
+	 */
+	void RemoveFiles();
+
+	const OfflineStats& Stats() const { return stats; }
+
+private:
+	// Where a queued line lives in the log
+	struct PendingLine
+	{
+		uint32_t segment = 0;
+		long offset = 0;        // Offset of the line text in the segment file
+		uint32_t length = 0;    // Length of the line text
+		uint32_t recordSize = 0; // Bytes of the whole record, frame header included
+	};
+
+	struct Recipient
+	{
+		bool tracked = false;
+		int64_t trackedSince = 0;               // Seconds since the epoch
+		std::map<uint64_t, PendingLine> lines; // By sequence number, oldest first
+		size_t bytes = 0;                       // Sum of the line lengths
+		uint64_t consumedUpTo = 0;              // Replay only: lines up to here were dropped or delivered
+	};
+
+	struct Segment
+	{
+		size_t bytes = 0;     // Bytes written to the file
+		size_t liveBytes = 0; // Bytes of records holding pending lines
+	};
+
+	std::string SegmentPath(uint32_t segment) const;
+	bool StartSegment();
+	void Replay(uint32_t segment);
+	void ApplyRecord(uint32_t segment, long recordOffset, const char* payload, size_t length);
+	void AppendRecord(uint8_t type, uint64_t sequence, const std::string& nickname,
+					  const char* text, size_t length, PendingLine* line);
+	void AppendLine(Recipient& recipient, const std::string& nickname, uint64_t sequence,
+					const char* message, size_t length);
+	void Forget(Recipient& recipient, uint64_t upTo);
+	void AppendTrack(const std::string& nickname, const Recipient& recipient);
+	void Untrack(std::map<std::string, Recipient>::iterator it);
+	void ExpireIdle(int64_t now);
+	bool ReadLines(const std::vector<std::pair<uint64_t, PendingLine>>& lines, std::vector<std::string>& texts);
+	void CompactIfNeeded();
+	void Compact();
+
+	OfflineOptions options;
+	OfflineStats stats;
+	std::map<std::string, Recipient> recipients;
+	std::map<uint32_t, Segment> segments; // Every segment on disk, the active one last
+	uint32_t activeSegment = 0;
+	FILE* activeFile = nullptr;
+	uint64_t nextSequence = 1;
+	int64_t lastExpiryCheck = 0;
+	bool compacting = false;
+};
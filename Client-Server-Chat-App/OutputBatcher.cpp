@@ -0,0 +1,213 @@
+/**
+ * @file OutputBatcher.cpp
+ * @brief Implementation of per-connection write coalescing.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "OutputBatcher.h"
+#include "Framing.h"
+
+#include <algorithm>
+
+OutputBatcher::OutputBatcher(const BatchingOptions& options) : options(options)
+{
+}
+
+std::shared_ptr<const std::string> OutputBatcher::MakeFrame(const char* payload, size_t length)
+{
+	std::shared_ptr<std::string> frame = std::make_shared<std::string>();
+	frame->reserve(FRAME_HEADER_SIZE + length);
+	AppendFrame(*frame, payload, length);
+	return frame;
+}
+
+void OutputBatcher::Attach(Connection* connection)
+{
+	if (options.tuneSockets)
+		connection->SetNoDelay(true);
+	std::lock_guard<std::mutex> lock(mutex);
+	connections[connection] = Pending();
+}
+
+void OutputBatcher::Detach(Connection* connection)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	connections.erase(connection);
+}
+
+void OutputBatcher::Queue(Connection* connection, const char* payload, size_t length)
+{
+	std::shared_ptr<const std::string> frame = MakeFrame(payload, length);
+	std::lock_guard<std::mutex> lock(mutex);
+	QueueLocked(connection, frame);
+}
+
+void OutputBatcher::Queue(Connection* connection, const std::shared_ptr<const std::string>& frame)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	QueueLocked(connection, frame);
+}
+
+void OutputBatcher::QueueBacklog(Connection* connection, const std::shared_ptr<const std::string>& frames)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	QueueLocked(connection, frames, true);
+}
+
+void OutputBatcher::QueueLocked(Connection* connection, const std::shared_ptr<const std::string>& frame, bool backlog)
+{
+	Pending& pending = connections[connection];
+	if (pending.broken)
+		return;
+	if (backlog)
+		pending.allowance += frame->size();
+	// The peer stopped reading: drop it rather than buffer without bound
+	else if (options.maxQueuedBytes > 0 && pending.bytes > 0 &&
+			 pending.bytes + frame->size() > options.maxQueuedBytes + pending.allowance)
+	{
+		pending.frames.clear();
+		pending.headOffset = 0;
+		pending.bytes = 0;
+		pending.broken = true;
+		stats.overflows++;
+		return;
+	}
+	if (pending.frames.empty())
+		pending.firstQueued = std::chrono::steady_clock::now();
+	pending.frames.push_back(frame);
+	pending.bytes += frame->size();
+	stats.frames++;
+	if (pending.bytes >= options.byteBudget)
+		FlushLocked(connection, pending);
+}
+
+void OutputBatcher::FlushLocked(Connection* connection, Pending& pending)
+{
+	pending.blocked = false;
+	if (pending.frames.empty())
+		return;
+	stats.flushes++;
+
+	ConstBuffer buffers[SOCKET_MAX_GATHER];
+	bool corked = false;
+	while (!pending.frames.empty())
+	{
+		size_t count = 0;
+		for (auto it = pending.frames.begin(); it != pending.frames.end() && count < SOCKET_MAX_GATHER; ++it, ++count)
+		{
+			size_t skip = count == 0 ? pending.headOffset : 0;
+			buffers[count].data = (*it)->data() + skip;
+			buffers[count].length = (*it)->size() - skip;
+		}
+		// More than one write is needed: cork so the boundary between writes does not produce a short segment
+		if (!corked && options.tuneSockets && count < pending.frames.size())
+			corked = connection->SetCork(true);
+
+		long sent = connection->SendV(buffers, count);
+		stats.writes++;
+		if (sent == SOCKET_ERROR)
+		{
+			// A would-block keeps the rest for the next flush; anything else means the peer is gone
+			if (connection->WouldBlock())
+			{
+				pending.blocked = true;
+			}
+			else
+			{
+				pending.frames.clear();
+				pending.headOffset = 0;
+				pending.bytes = 0;
+				pending.broken = true;
+			}
+			break;
+		}
+		stats.bytes += (unsigned long long)sent;
+		pending.bytes -= (size_t)sent;
+
+		size_t remaining = (size_t)sent;
+		while (remaining > 0)
+		{
+			size_t left = pending.frames.front()->size() - pending.headOffset;
+			if (remaining < left)
+			{
+				pending.headOffset += remaining;
+				break;
+			}
+			remaining -= left;
+			pending.frames.pop_front();
+			pending.headOffset = 0;
+		}
+	}
+	if (corked)
+		connection->SetCork(false);
+	if (pending.frames.empty())
+		pending.allowance = 0;
+	// Whatever is left over starts a fresh window
+	pending.firstQueued = std::chrono::steady_clock::now();
+}
+
+void OutputBatcher::FlushDue()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto now = std::chrono::steady_clock::now();
+	auto window = std::chrono::microseconds(options.windowMicros);
+	for (auto& pair : connections)
+	{
+		if (!pair.second.frames.empty() && now - pair.second.firstQueued >= window)
+			FlushLocked(pair.first, pair.second);
+	}
+}
+
+void OutputBatcher::FlushAll()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& pair : connections)
+		FlushLocked(pair.first, pair.second);
+}
+
+void OutputBatcher::Flush(Connection* connection)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = connections.find(connection);
+	if (it != connections.end())
+		FlushLocked(connection, it->second);
+}
+
+long long OutputBatcher::MicrosUntilDue() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto now = std::chrono::steady_clock::now();
+	long long earliest = -1;
+	for (const auto& pair : connections)
+	{
+		if (pair.second.frames.empty() || pair.second.blocked)
+			continue;
+		long long waited = std::chrono::duration_cast<std::chrono::microseconds>(now - pair.second.firstQueued).count();
+		long long left = std::max(0LL, (long long)options.windowMicros - waited);
+		if (earliest < 0 || left < earliest)
+			earliest = left;
+	}
+	return earliest;
+}
+
+bool OutputBatcher::IsBroken(Connection* connection) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = connections.find(connection);
+	return it != connections.end() && it->second.broken;
+}
+
+bool OutputBatcher::IsBlocked(Connection* connection) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = connections.find(connection);
+	return it != connections.end() && it->second.blocked;
+}
+
+BatchingStats OutputBatcher::Stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
@@ -0,0 +1,178 @@
+#pragma once
+/**
+ * @file OutputBatcher.h
+ * @brief Per-connection write coalescing for the client and server send paths.
+ *
+ * Instead of one send() per message (and per recipient), outgoing messages are
+ * framed and queued per connection. A connection is flushed once its oldest
+ * queued frame has waited for the batching window, or as soon as the queued
+ * bytes reach the byte budget. A flush hands every queued frame to the kernel
+ * with a single gathered write.
+ *
+ * TCP connections are switched to TCP_NODELAY when attached: batching is done
+ * here, so Nagle's algorithm would only add a round-trip of delay to every
+ * flush. Where TCP_CORK exists (Linux) a flush too large for one gathered write
+ * is corked so the kernel still emits full segments across the writes.
+ *
+ * Frames are reference-counted, so a message broadcast to many clients is
+ * encoded once and shared by every recipient's queue.
+ *
+ * On a non-blocking connection a write that would block leaves the rest
+ * queued; the connection is then "blocked" until its next flush, and the caller
+ * should wait for it to become writable (IsBlocked()) and Flush() it then,
+ * whatever its window, instead of spinning on MicrosUntilDue(). A connection whose queue would grow beyond maxQueuedBytes
+ * is not keeping up: its queue is discarded and it is marked broken, like one
+ * whose write failed, for the caller to disconnect.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Transport.h"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Default time a queued frame may wait for company before it is flushed, in microseconds
+#define DEFAULT_BATCH_WINDOW_US 0
+
+// Default number of queued bytes that forces a flush regardless of the window
+#define DEFAULT_BATCH_BYTES (64 * 1024)
+
+// Default number of unsent bytes one connection may have queued before it is marked broken
+#define DEFAULT_MAX_QUEUED_BYTES (8 * 1024 * 1024)
+
+/**
+ * @brief Tuning of an OutputBatcher.
+ */
+struct BatchingOptions
+{
+	// 0 flushes at the end of every pass of the caller's loop
+	unsigned int windowMicros = DEFAULT_BATCH_WINDOW_US;
+	size_t byteBudget = DEFAULT_BATCH_BYTES;
+	// 0 lets a queue grow without bound; a single frame on an empty queue is always accepted
+	size_t maxQueuedBytes = DEFAULT_MAX_QUEUED_BYTES;
+	// Use TCP_NODELAY on attached sockets and TCP_CORK around multi-write flushes
+	bool tuneSockets = true;
+};
+
+/**
+ * @brief Counters for benchmarks and diagnostics.
+ */
+struct BatchingStats
+{
+	unsigned long long frames = 0;  // Frames queued
+	unsigned long long flushes = 0; // Connection flushes performed
+	unsigned long long writes = 0;  // Gathered write calls issued
+	unsigned long long bytes = 0;   // Bytes handed to the kernel
+	unsigned long long overflows = 0; // Connections marked broken for exceeding maxQueuedBytes
+};
+
+/**
+ * @brief Coalesces framed messages per connection and flushes them in bulk.
+ *
+ * Thread-safe, so a sender thread and a timer thread may share one batcher.
+ * Works with blocking connections (a flush waits until everything is written)
+ * and non-blocking ones (a flush writes what the kernel takes and never waits);
+ * a server loop shared by many clients needs the latter.
+ */
+class OutputBatcher
+{
+public:
+	explicit OutputBatcher(const BatchingOptions& options = BatchingOptions());
+
+	/**
+	 * @brief Encodes a payload as a frame that can be queued on many connections.
+	 */
+	static std::shared_ptr<const std::string> MakeFrame(const char* payload, size_t length);
+
+	/**
+	 * @brief Starts tracking a connection and applies the socket options.
+	 */
+	void Attach(Connection* connection);
+
+	/**
+	 * @brief Stops tracking a connection and discards whatever is still queued for it.
+	 */
+	void Detach(Connection* connection);
+
+	/**
+	 * @brief Frames and queues one message; flushes the connection if the byte budget is reached.
+	 */
+	void Queue(Connection* connection, const char* payload, size_t length);
+
+	/**
+	 * @brief Queues an already encoded frame (see MakeFrame).
+	 */
+	void Queue(Connection* connection, const std::shared_ptr<const std::string>& frame);
+
+	/**
+	 * @brief Queues encoded frames the connection is owed in full, such as a replayed backlog.
+	 *
+	 * They are exempt from maxQueuedBytes: until the queue has drained, the
+	 * connection may hold that much more than the limit.
+	 */
+	void QueueBacklog(Connection* connection, const std::shared_ptr<const std::string>& frames);
+
+	/**
+	 * @brief Flushes every connection whose batching window has expired.
+	 */
+	void FlushDue();
+
+	/**
+	 * @brief Flushes every connection right away.
+	 */
+	void FlushAll();
+
+	/**
+	 * @brief Flushes one connection right away.
+	 */
+	void Flush(Connection* connection);
+
+	/**
+	 * @brief Time until the next connection becomes due, in microseconds.
+	 *
+	 * Blocked connections are left out: they are retried once writable.
+	 *
+	 * @return -1 if nothing is queued, 0 if something is already due.
+	 */
+	long long MicrosUntilDue() const;
+
+	/**
+	 * @brief True once a write on the connection failed for a reason other than would-block.
+	 */
+	bool IsBroken(Connection* connection) const;
+
+	/**
+	 * @brief True if the last flush of the connection stopped because the write would block.
+	 */
+	bool IsBlocked(Connection* connection) const;
+
+	BatchingStats Stats() const;
+
+	const BatchingOptions& Options() const { return options; }
+
+private:
+	struct Pending
+	{
+		std::deque<std::shared_ptr<const std::string>> frames;
+		size_t headOffset = 0; // Bytes of frames.front() already written
+		size_t bytes = 0;      // Unwritten bytes across all frames
+		bool broken = false;   // A write failed or the queue overflowed; nothing more is sent
+		bool blocked = false;  // The last write would have blocked
+		size_t allowance = 0;  // Bytes of QueueBacklog() allowed on top of maxQueuedBytes until the queue drains
+		std::chrono::steady_clock::time_point firstQueued;
+	};
+
+	void QueueLocked(Connection* connection, const std::shared_ptr<const std::string>& frame, bool backlog = false);
+	void FlushLocked(Connection* connection, Pending& pending);
+
+	BatchingOptions options;
+	mutable std::mutex mutex;
+	std::map<Connection*, Pending> connections;
+	BatchingStats stats;
+};
@@ -0,0 +1,633 @@
+/**
+ * @file RelayEngine.cpp
+ * @brief Message handling of the chat server: relaying, /users and nickname changes.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "RelayEngine.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <utility>
+#include <vector>
+
+void LogMessage(const char* message)
+{
+	std::ofstream logFile("server.log", std::ios::app);
+	if (logFile.is_open())
+	{
+		// Get current time as system time
+		auto now = std::chrono::system_clock::now();
+
+		// Convert system time to time_t
+		std::time_t currentTime = std::chrono::system_clock::to_time_t(now);
+
+		// Convert time_t to tm structure
+		std::tm localTime;
+#ifdef _WIN32
+		localtime_s(&localTime, &currentTime); // Use localtime_s for thread safety
+#else
+		localtime_r(&currentTime, &localTime);
+#endif
+
+		// Log the message with timestamp
+		logFile << std::put_time(&localTime, "(%m/%d/%H:%M)") << " " << message << std::endl;
+		logFile.close();
+	}
+	else
+	{
+		printf("Could not open log file.\n");
+	}
+}
+
+// Helper to trim whitespace
+
+std::string trim(const std::string& s) {
+
+	size_t start = s.find_first_not_of(" \t\r\n");
+
+	size_t end = s.find_last_not_of(" \t\r\n");
+
+	return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
+
+}
+
+// 1 to MAX_NICKNAME_LENGTH characters, no ':' (it ends the nickname in a chat line) and no control characters
+static bool IsValidNickname(const std::string& nickname)
+{
+	if (nickname.empty() || nickname.length() > MAX_NICKNAME_LENGTH)
+		return false;
+	for (char c : nickname)
+	{
+		if (c == ':' || (unsigned char)c < 0x20 || c == 0x7F)
+			return false;
+	}
+	return true;
+}
+
+static std::string InvalidNicknameMessage(const std::string& nickname)
+{
+	return "Nickname '" + nickname + "' is not valid (1 to " + std::to_string(MAX_NICKNAME_LENGTH) +
+		   " characters, no ':' or control characters).";
+}
+
+RelayEngine::RelayEngine(FederationBus& federation, OutputBatcher& batcher, const RelayOptions& options,
+						 OfflineStore* offline)
+	: federation(federation), batcher(batcher), options(options), offline(offline),
+	  clients((size_t)std::max(options.maxClients, 1)), readBuffer(std::max(options.readBufferSize, (size_t)1))
+{
+	RefreshUsers();
+}
+
+RelayEngine::~RelayEngine()
+{
+	for (ClientSlot& slot : clients)
+	{
+		if (slot.connection)
+		{
+			batcher.Detach(slot.connection.get());
+			slot.connection->Close();
+		}
+	}
+}
+
+int RelayEngine::AddClient(std::unique_ptr<Connection> connection)
+{
+#ifndef _WIN32
+	// FD_SET() cannot hold descriptors from FD_SETSIZE on
+	if (connection->Handle() != INVALID_SOCKET && connection->Handle() >= FD_SETSIZE)
+	{
+		connection->Close();
+		return -1;
+	}
+#endif
+	for (int clientIndex = 0; clientIndex < Capacity(); clientIndex++)
+	{
+		if (!clients[clientIndex].connection) {
+			// The relay loop serves every client; a full socket must not stop it
+			connection->SetNonBlocking();
+			batcher.Attach(connection.get());
+			clients[clientIndex].connection = std::move(connection);
+			clients[clientIndex].reader = FrameReader();
+			return clientIndex;
+		}
+	}
+	connection->Close();
+	return -1;
+}
+
+Connection* RelayEngine::ClientConnection(int clientIndex) const
+{
+	return clients[clientIndex].connection.get();
+}
+
+size_t RelayEngine::ClientCount() const
+{
+	size_t count = 0;
+	for (const ClientSlot& slot : clients)
+	{
+		if (slot.connection)
+			count++;
+	}
+	return count;
+}
+
+void RelayEngine::AddToReadSet(fd_set& readfds, int& maxSD) const
+{
+	for (const ClientSlot& slot : clients)
+	{
+		if (!slot.connection || slot.connection->Handle() == INVALID_SOCKET)
+			continue;
+		FD_SET(slot.connection->Handle(), &readfds);
+		maxSD = std::max(maxSD, (int)slot.connection->Handle());
+	}
+}
+
+void RelayEngine::ProcessReadSet(const fd_set& readfds)
+{
+	for (int clientIndex = 0; clientIndex < Capacity(); clientIndex++)
+	{
+		Connection* connection = clients[clientIndex].connection.get();
+		if (connection != nullptr && connection->Handle() != INVALID_SOCKET &&
+			FD_ISSET(connection->Handle(), &readfds))
+		{
+			OnReadable(clientIndex);
+		}
+	}
+}
+
+void RelayEngine::AddToWriteSet(fd_set& writefds, int& maxSD) const
+{
+	for (const ClientSlot& slot : clients)
+	{
+		if (!slot.connection || slot.connection->Handle() == INVALID_SOCKET ||
+			!batcher.IsBlocked(slot.connection.get()))
+			continue;
+		FD_SET(slot.connection->Handle(), &writefds);
+		maxSD = std::max(maxSD, (int)slot.connection->Handle());
+	}
+}
+
+void RelayEngine::ProcessWriteSet(const fd_set& writefds)
+{
+	for (const ClientSlot& slot : clients)
+	{
+		Connection* connection = slot.connection.get();
+		// Waiting for the window would leave the socket writable and select() returning at once until then
+		if (connection != nullptr && connection->Handle() != INVALID_SOCKET &&
+			FD_ISSET(connection->Handle(), &writefds) && batcher.IsBlocked(connection))
+		{
+			batcher.Flush(connection);
+		}
+	}
+}
+
+size_t RelayEngine::DropBrokenClients()
+{
+	size_t dropped = 0;
+	for (int clientIndex = 0; clientIndex < Capacity(); clientIndex++)
+	{
+		Connection* connection = clients[clientIndex].connection.get();
+		if (connection == nullptr || !batcher.IsBroken(connection))
+			continue;
+		if (options.echoEvents)
+			printf("Client index %d is not taking its messages, disconnecting\n", clientIndex);
+		RemoveClient(clientIndex);
+		dropped++;
+	}
+	return dropped;
+}
+
+void RelayEngine::OnReadable(int clientIndex)
+{
+	ClientSlot& slot = clients[clientIndex];
+	if (!slot.connection)
+		return;
+
+	char* buffer = readBuffer.data();
+	long valueRead = slot.connection->Recv(buffer, readBuffer.size());
+	if (valueRead == SOCKET_ERROR && slot.connection->WouldBlock())
+		return;
+	if (valueRead > 0)
+	{
+		slot.reader.Feed(buffer, (size_t)valueRead);
+	}
+	// A single read may carry several messages, or only part of one
+	std::string msg;
+	while (valueRead > 0 && slot.reader.Next(msg))
+	{
+		HandleMessage(clientIndex, msg);
+	}
+	if (valueRead <= 0 || slot.reader.HasError())
+	{
+		RemoveClient(clientIndex);
+	}
+}
+
+void RelayEngine::RemoveClient(int clientIndex)
+{
+	Connection* connection = clients[clientIndex].connection.get();
+	if (options.echoEvents)
+		printf("Client disconnected, socket fd is %d, client index is %d\n", (int)connection->Handle(), clientIndex);
+	batcher.Detach(connection);
+	connection->Close();
+	clients[clientIndex].connection.reset();
+	clients[clientIndex].muted = false;
+	usersChanged = true;
+	// Free the nicknames this client held so they can be claimed again cluster-wide
+	for (auto it = nameToClient.begin(); it != nameToClient.end();)
+	{
+		if (it->second == clientIndex)
+		{
+			federation.ReleaseNickname(it->first);
+			// Keep what is said from now on until the nickname comes back
+			if (offline != nullptr)
+				offline->Track(it->first);
+			it = nameToClient.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+// Queues a message for every connected client except the one at skipIndex (-1 sends to all)
+void RelayEngine::BroadcastToClients(int skipIndex, const char* message, size_t length)
+{
+	// Encoded once, shared by every recipient's queue
+	std::shared_ptr<const std::string> frame = OutputBatcher::MakeFrame(message, length);
+	for (int i = 0; i < Capacity(); i++)
+	{
+		if (clients[i].connection && i != skipIndex)
+		{
+			batcher.Queue(clients[i].connection.get(), frame);
+		}
+	}
+	if (offline != nullptr)
+		offline->EnqueueForAll(message, length);
+}
+
+// Queues a reply for a single client
+void RelayEngine::SendToClient(int clientIndex, const std::string& message)
+{
+	batcher.Queue(clients[clientIndex].connection.get(), message.c_str(), message.length());
+}
+
+// Records that a client uses a nickname and hands it what was said while the nickname was away
+void RelayEngine::ClaimNickname(int clientIndex, const std::string& nickname)
+{
+	nameToClient[nickname] = clientIndex;
+	federation.ClaimNickname(nickname);
+	if (mutedNicknames.count(nickname) != 0)
+		clients[clientIndex].muted = true;
+	usersChanged = true;
+	DeliverOffline(clientIndex, nickname);
+}
+
+// Handles "/nick <nickname>": checks the new nickname, swaps it in and tells everybody
+void RelayEngine::ChangeNickname(int clientIndex, const std::string& newNickname)
+{
+	if (!IsValidNickname(newNickname))
+	{
+		SendToClient(clientIndex, InvalidNicknameMessage(newNickname));
+		return;
+	}
+	if (IsNicknameTaken(clientIndex, newNickname))
+	{
+		SendToClient(clientIndex, "Nickname '" + newNickname + "' is already taken.");
+		return;
+	}
+	std::string oldNickname = NicknameOf(clientIndex);
+	if (oldNickname != newNickname)
+	{
+		if (!oldNickname.empty())
+		{
+			nameToClient.erase(oldNickname);
+			federation.ReleaseNickname(oldNickname);
+		}
+		ClaimNickname(clientIndex, newNickname);
+	}
+	// A control frame: clients cannot send one, so nobody can fake this confirmation through the relay
+	SendToClient(clientIndex, NICKNAME_CONFIRMATION_PREFIX + newNickname);
+	if (oldNickname.empty() || oldNickname == newNickname)
+		return;
+
+	//Broadcast the nickname change to the other clients, including the other nodes
+	std::string announceMsg = oldNickname + " changed nickname to " + newNickname;
+	BroadcastToClients(clientIndex, announceMsg.c_str(), announceMsg.length());
+	federation.PublishChat(announceMsg.c_str(), announceMsg.length());
+	if (options.logMessages)
+		LogMessage(announceMsg.c_str());
+}
+
+// True if the nickname belongs to another local client or to a user on a reachable node
+bool RelayEngine::IsNicknameTaken(int clientIndex, const std::string& nickname) const
+{
+	auto owner = nameToClient.find(nickname);
+	if (owner != nameToClient.end())
+		return owner->second != clientIndex;
+	return federation.IsNicknameTakenRemotely(nickname);
+}
+
+// Nickname held by a client, or an empty string
+std::string RelayEngine::NicknameOf(int clientIndex) const
+{
+	for (const auto& pair : nameToClient)
+	{
+		if (pair.second == clientIndex)
+			return pair.first;
+	}
+	return std::string();
+}
+
+// Sends a client everything queued for its nickname while it was away, in one write
+void RelayEngine::DeliverOffline(int clientIndex, const std::string& nickname)
+{
+	if (offline == nullptr)
+		return;
+	std::string frames;
+	uint64_t upTo = 0;
+	size_t count = offline->Peek(nickname, frames, upTo);
+	if (count > 0)
+	{
+		if (options.echoMessages)
+			printf("Delivering %zu offline messages to '%s'\n", count, nickname.c_str());
+		// The notice and the already framed lines are queued and written as one block. The client is owed
+		// all of it, so it does not count against client-backlog
+		const std::string notice = "You have " + std::to_string(count) + " messages from while you were away:";
+		std::string burst;
+		burst.reserve(FRAME_HEADER_SIZE + notice.length() + frames.size());
+		AppendFrame(burst, notice.c_str(), notice.length());
+		burst += frames;
+		Connection* connection = clients[clientIndex].connection.get();
+		batcher.QueueBacklog(connection, std::make_shared<const std::string>(std::move(burst)));
+		batcher.Flush(connection);
+		// The connection failed on the way: keep the lines for the next time the nickname comes back
+		if (batcher.IsBroken(connection))
+			return;
+	}
+	offline->Acknowledge(nickname, upTo);
+}
+
+void RelayEngine::HandleMessage(int clientIndex, const std::string& msg)
+{
+	if (options.echoMessages)
+		printf("%s\n", msg.c_str());
+	if (options.logMessages)
+		LogMessage(msg.c_str());
+	// Control frames only ever go from the server to a client
+	if (msg.compare(0, strlen(CONTROL_FRAME_PREFIX), CONTROL_FRAME_PREFIX) == 0) {
+		SendToClient(clientIndex, "Messages cannot start with a control character.");
+		return;
+	}
+	// Extract nickname (format: "nickname: message")
+	size_t sep = msg.find(": ");
+
+	// Detect if the message is exactly "/users"
+	if (msg == "/users") {
+		RefreshUsers();
+		std::shared_ptr<const UserSnapshot> snapshot = Users();
+		std::string userList = "Connected users:";
+		if (snapshot->users.empty()) {
+			userList += " (none)";
+		}
+		else {
+			const std::string localNode = LocalNodeName();
+			for (const UserInfo& user : snapshot->users) {
+				userList += "\n- " + user.nickname;
+				if (user.node != localNode)
+					userList += " (" + user.node + ")";
+			}
+		}
+		SendToClient(clientIndex, userList);
+		return; // Do not broadcast this command
+	}
+
+	// "/hello <nickname>" is sent by clients right after connecting
+	if (msg.rfind("/hello ", 0) == 0) {
+		std::string nickname = trim(msg.substr(7));
+		if (!IsValidNickname(nickname))
+		{
+			SendToClient(clientIndex, InvalidNicknameMessage(nickname));
+			return;
+		}
+		if (IsNicknameTaken(clientIndex, nickname))
+		{
+			SendToClient(clientIndex, "Nickname '" + nickname + "' is already taken.");
+			return;
+		}
+		if (nameToClient.find(nickname) == nameToClient.end())
+			ClaimNickname(clientIndex, nickname);
+		return; // Do not broadcast this command
+	}
+
+	// "/nick <nickname>" renames the client; it takes the new name only once the confirmation arrives
+	if (msg.rfind("/nick ", 0) == 0) {
+		ChangeNickname(clientIndex, trim(msg.substr(6)));
+		return; // Do not broadcast this command
+	}
+
+	if (clients[clientIndex].muted) {
+		SendToClient(clientIndex, "You are muted by the server.");
+		return;
+	}
+
+	// Every node must be able to take the line, or federated users would miss it
+	if (msg.length() > federation.MaxChatLength())
+	{
+		SendToClient(clientIndex, "Message too long (at most " + std::to_string(federation.MaxChatLength()) + " bytes).");
+		return;
+	}
+	// Every relayed line starts with the sender's own nickname, so nobody can speak as someone else
+	if (sep == std::string::npos)
+	{
+		SendToClient(clientIndex, "Messages must start with your nickname (\"nickname: message\").");
+		return;
+	}
+	std::string nickname = msg.substr(0, sep);
+	std::string ownNickname = NicknameOf(clientIndex);
+	if (ownNickname.empty())
+	{
+		// A client that never announced itself takes the nickname of its first message
+		if (!IsValidNickname(nickname))
+		{
+			SendToClient(clientIndex, InvalidNicknameMessage(nickname));
+			return;
+		}
+		if (IsNicknameTaken(clientIndex, nickname))
+		{
+			SendToClient(clientIndex, "Nickname '" + nickname + "' is already taken. Please choose another one with /nick.");
+			return;
+		}
+		ClaimNickname(clientIndex, nickname);
+	}
+	else if (nickname != ownNickname)
+	{
+		SendToClient(clientIndex, "You can only send messages as '" + ownNickname + "'.");
+		return;
+	}
+	BroadcastToClients(clientIndex, msg.c_str(), msg.length());
+	federation.PublishChat(msg.c_str(), msg.length());
+}
+
+void RelayEngine::OnFederationEvent(const FederationEvent& event)
+{
+	if (event.type == FederationEvent::RemoteChat)
+	{
+		// The origin node refuses these from its clients; never pass one on as if it came from us
+		if (event.text.compare(0, strlen(CONTROL_FRAME_PREFIX), CONTROL_FRAME_PREFIX) == 0)
+			return;
+		if (options.echoMessages)
+			printf("[%s] %s\n", event.origin.c_str(), event.text.c_str());
+		if (options.logMessages)
+			LogMessage(event.text.c_str());
+		BroadcastToClients(-1, event.text.c_str(), event.text.length());
+	}
+	else if (event.type == FederationEvent::NicknameLost)
+	{
+		auto it = nameToClient.find(event.text);
+		if (it != nameToClient.end())
+		{
+			std::string errorMsg = "Nickname '" + event.text + "' is already taken on node '" + event.origin +
+								   "'. Please choose another one with /nick.";
+			SendToClient(it->second, errorMsg);
+			nameToClient.erase(it);
+			usersChanged = true;
+		}
+	}
+}
+
+bool RelayEngine::KickClient(const std::string& nickname)
+{
+	auto it = nameToClient.find(nickname);
+	if (it == nameToClient.end())
+		return false;
+
+	int clientIndex = it->second;
+	if (!clients[clientIndex].connection)
+		return false;
+	Kick(clientIndex);
+	return true;
+}
+
+// Tells a client it was kicked, if its socket takes the notice right away, and disconnects it
+void RelayEngine::Kick(int clientIndex)
+{
+	Connection* connection = clients[clientIndex].connection.get();
+	const std::string notice = "You have been kicked by the server.";
+	batcher.Queue(connection, notice.c_str(), notice.length());
+	// Non-blocking, so this is a single attempt; a client that stopped reading just misses the notice
+	if (!batcher.IsBlocked(connection))
+		batcher.Flush(connection);
+	RemoveClient(clientIndex);
+}
+
+void RelayEngine::Execute(const AdminCommand& command)
+{
+	switch (command.type)
+	{
+	case AdminCommand::Kick:
+	{
+		bool kicked = KickClient(command.nickname);
+		if (options.echoEvents && kicked)
+			printf("Client '%s' has been kicked.\n", command.nickname.c_str());
+		else if (options.echoEvents)
+			printf("No client with nickname '%s' found.\n", command.nickname.c_str());
+		break;
+	}
+	case AdminCommand::KickAll:
+	{
+		size_t kicked = 0;
+		for (int clientIndex = 0; clientIndex < Capacity(); clientIndex++)
+		{
+			if (!clients[clientIndex].connection)
+				continue;
+			Kick(clientIndex);
+			kicked++;
+		}
+		if (options.echoEvents)
+			printf("%zu clients have been kicked.\n", kicked);
+		break;
+	}
+	case AdminCommand::Mute:
+	case AdminCommand::Unmute:
+	{
+		bool mute = command.type == AdminCommand::Mute;
+		if (mute)
+			mutedNicknames.insert(command.nickname);
+		else
+			mutedNicknames.erase(command.nickname);
+		auto it = nameToClient.find(command.nickname);
+		if (it != nameToClient.end())
+		{
+			clients[it->second].muted = mute;
+			SendToClient(it->second, mute ? "You have been muted by the server." : "You are no longer muted.");
+		}
+		usersChanged = true;
+		if (options.echoEvents)
+			printf("'%s' is %s.\n", command.nickname.c_str(), mute ? "muted" : "no longer muted");
+		break;
+	}
+	}
+}
+
+size_t RelayEngine::ProcessAdmin(AdminQueue& queue)
+{
+	AdminCommand command;
+	size_t count = 0;
+	while (count < ADMIN_COMMANDS_PER_PASS && queue.Poll(command))
+	{
+		Execute(command);
+		count++;
+	}
+	// Leave the rest for the next pass, but make sure there is one
+	if (count == ADMIN_COMMANDS_PER_PASS)
+		queue.Wake();
+	return count;
+}
+
+std::string RelayEngine::LocalNodeName() const
+{
+	return federation.NodeId().empty() ? "local" : federation.NodeId();
+}
+
+void RelayEngine::RefreshUsers()
+{
+	if (!usersChanged && users && federationGeneration == federation.Generation())
+		return;
+	std::shared_ptr<UserSnapshot> snapshot = std::make_shared<UserSnapshot>();
+	snapshot->version = users ? users->version + 1 : 1;
+	const std::string localNode = LocalNodeName();
+	for (const auto& pair : nameToClient)
+	{
+		UserInfo user;
+		user.nickname = pair.first;
+		user.node = localNode;
+		user.muted = clients[pair.second].muted;
+		snapshot->users.push_back(user);
+	}
+	for (const auto& pair : federation.RemoteUsers())
+	{
+		UserInfo user;
+		user.nickname = pair.first;
+		user.node = pair.second;
+		user.muted = mutedNicknames.count(pair.first) != 0;
+		snapshot->users.push_back(user);
+	}
+	std::atomic_store(&users, std::shared_ptr<const UserSnapshot>(snapshot));
+	usersChanged = false;
+	federationGeneration = federation.Generation();
+}
+
+std::shared_ptr<const UserSnapshot> RelayEngine::Users() const
+{
+	return std::atomic_load(&users);
+}
@@ -0,0 +1,225 @@
+#pragma once
+/**
+ * @file RelayEngine.h
+ * @brief Transport-independent core of the chat server.
+ *
+ * The relay engine owns the connected clients, decodes their frames, keeps the
+ * nickname table and relays messages to the other clients and to federated
+ * nodes. It never waits for I/O itself: the server loop (or a benchmark) tells
+ * it which client has data with OnReadable(), and every reply goes through the
+ * shared OutputBatcher. Client connections are switched to non-blocking mode,
+ * so a client that stops reading only grows its own queue until the batcher
+ * gives up on it (see DropBrokenClients()). This is what lets the same code run over TCP, Unix
+ * domain sockets or in-memory loopback connections.
+ *
+ * With an OfflineStore, nicknames that disconnect keep receiving broadcasts in
+ * their offline queue, which is delivered in one burst when the nickname is
+ * claimed again (by "/hello <nickname>", a message or a nickname change).
+ *
+ * Nicknames are changed with "/nick <nickname>", which the engine confirms
+ * with a NICKNAME_CONFIRMATION_PREFIX control frame; lines from clients that
+ * start with CONTROL_FRAME_PREFIX are refused, so only the server can send one.
+ * A relayed line must start with the sender's own nickname (the first line of a
+ * client that never announced one claims it), and a nickname held by another
+ * client, on this node or a reachable one, cannot be claimed.
+ *
+ * The engine belongs to the thread running the relay loop. Other threads reach
+ * it only through an AdminQueue (see AdminControl.h), drained by
+ * ProcessAdmin(), and through the user snapshot returned by Users(), which is
+ * republished by RefreshUsers() whenever the set of users changed.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "AdminControl.h"
+#include "Federation.h"
+#include "Framing.h"
+#include "OfflineQueue.h"
+#include "OutputBatcher.h"
+#include "Transport.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// Default number of client slots; connections beyond them are refused
+#define DEFAULT_MAX_CLIENTS 10
+
+// Default number of bytes read from a client per call
+#define DEFAULT_READ_BUFFER_SIZE 1024
+
+/**
+ * @brief Appends a timestamped line to server.log.
+ */
+void LogMessage(const char* message);
+
+/**
+ * @brief Returns s without leading and trailing whitespace.
+ */
+std::string trim(const std::string& s);
+
+/**
+ * @brief Behaviour switches of a RelayEngine.
+ */
+struct RelayOptions
+{
+	bool logMessages = true;  // Append every message to server.log
+	bool echoMessages = true; // Print every message on the server console
+	bool echoEvents = true;   // Print disconnections and the outcome of admin commands
+	int maxClients = DEFAULT_MAX_CLIENTS;             // Client slots
+	size_t readBufferSize = DEFAULT_READ_BUFFER_SIZE; // Bytes read from a client per call
+};
+
+/**
+ * @brief One user in a UserSnapshot.
+ */
+struct UserInfo
+{
+	std::string nickname;
+	std::string node; // Node the user is connected to ("local" on a standalone server)
+	bool muted = false;
+};
+
+/**
+ * @brief Immutable list of the users of the cluster, as seen by one node.
+ */
+struct UserSnapshot
+{
+	std::vector<UserInfo> users; // Sorted by nickname, local users first
+	uint64_t version = 0;        // Increases with every published snapshot
+};
+
+class RelayEngine
+{
+public:
+	/**
+	 * @param offline Offline queues to fill and drain, or nullptr to drop messages for absent users.
+	 *                Only used from the thread running the relay loop.
+	 */
+	RelayEngine(FederationBus& federation, OutputBatcher& batcher, const RelayOptions& options = RelayOptions(),
+				OfflineStore* offline = nullptr);
+	~RelayEngine();
+
+	RelayEngine(const RelayEngine&) = delete;
+	RelayEngine& operator=(const RelayEngine&) = delete;
+
+	/**
+	 * @brief Takes ownership of a newly accepted connection and makes it non-blocking.
+	 * @return The client index, or -1 if the server is full or the descriptor does not fit
+	 *         in a select() set (the connection is closed).
+	 */
+	int AddClient(std::unique_ptr<Connection> connection);
+
+	/**
+	 * @brief Reads from a client that has data, handles its complete messages and drops it on EOF.
+	 */
+	void OnReadable(int clientIndex);
+
+	/**
+	 * @brief Delivers a chat line or nickname conflict reported by the federation bus.
+	 */
+	void OnFederationEvent(const FederationEvent& event);
+
+	/**
+	 * @brief Adds the descriptors of socket-backed clients to a select() set.
+	 */
+	void AddToReadSet(fd_set& readfds, int& maxSD) const;
+
+	/**
+	 * @brief Calls OnReadable() for every client flagged in a select() set.
+	 */
+	void ProcessReadSet(const fd_set& readfds);
+
+	/**
+	 * @brief Adds the descriptors of clients whose output is waiting for the socket to drain.
+	 */
+	void AddToWriteSet(fd_set& writefds, int& maxSD) const;
+
+	/**
+	 * @brief Flushes the blocked clients flagged in a select() set, whatever their batching window.
+	 */
+	void ProcessWriteSet(const fd_set& writefds);
+
+	/**
+	 * @brief Disconnects clients the batcher gave up on (write error or too much unsent output).
+	 * @return The number of clients disconnected.
+	 */
+	size_t DropBrokenClients();
+
+	/**
+	 * @brief Disconnects the client using a nickname, telling it why first.
+	 *
+	 * The notice is best-effort: it is written only if the socket takes it
+	 * right away, so a client that stopped reading cannot stall the kick.
+	 *
+	 * @return false if no client uses the nickname.
+	 */
+	bool KickClient(const std::string& nickname);
+
+	/**
+	 * @brief Runs one admin command and prints the outcome on the console.
+	 */
+	void Execute(const AdminCommand& command);
+
+	/**
+	 * @brief Runs up to ADMIN_COMMANDS_PER_PASS queued admin commands.
+	 * @return The number of commands run.
+	 */
+	size_t ProcessAdmin(AdminQueue& queue);
+
+	/**
+	 * @brief Publishes a new user snapshot if local or remote users changed since the last one.
+	 */
+	void RefreshUsers();
+
+	/**
+	 * @brief Latest published user snapshot. Safe to call from any thread.
+	 */
+	std::shared_ptr<const UserSnapshot> Users() const;
+
+	// Connection of a client slot, or nullptr if the slot is free
+	Connection* ClientConnection(int clientIndex) const;
+
+	size_t ClientCount() const;
+
+	// Number of client slots (RelayOptions::maxClients); client indexes are below it
+	int Capacity() const { return (int)clients.size(); }
+
+private:
+	struct ClientSlot
+	{
+		std::unique_ptr<Connection> connection;
+		FrameReader reader;
+		bool muted = false;
+	};
+
+	void HandleMessage(int clientIndex, const std::string& msg);
+	void RemoveClient(int clientIndex);
+	void Kick(int clientIndex);
+	void BroadcastToClients(int skipIndex, const char* message, size_t length);
+	void SendToClient(int clientIndex, const std::string& message);
+	void DeliverOffline(int clientIndex, const std::string& nickname);
+	void ClaimNickname(int clientIndex, const std::string& nickname);
+	void ChangeNickname(int clientIndex, const std::string& newNickname);
+	bool IsNicknameTaken(int clientIndex, const std::string& nickname) const;
+	std::string NicknameOf(int clientIndex) const;
+	std::string LocalNodeName() const;
+
+	FederationBus& federation;
+	OutputBatcher& batcher;
+	RelayOptions options;
+	OfflineStore* offline;
+	std::vector<ClientSlot> clients;
+	std::vector<char> readBuffer;
+	// Map nickname to client index
+	std::map<std::string, int> nameToClient;
+	// Muted nicknames, kept across reconnections
+	std::set<std::string> mutedNicknames;
+	// Read by other threads with std::atomic_load only
+	std::shared_ptr<const UserSnapshot> users;
+	bool usersChanged = true;
+	uint64_t federationGeneration = 0;
+};
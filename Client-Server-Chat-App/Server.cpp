@@ -1,318 +1,272 @@
 /**
  * @file Server.cpp
- * @brief Multi-client chat server using Windows Sockets API.
+ * @brief Multi-client chat server loop for Windows and Linux.
  *
- * This server listens for incoming TCP connections on a specified port (8080).
- * It accepts up to MAX_CLIENTS simultaneous clients, relays messages between them,
- * and handles client disconnections. The implementation uses the Winsock2 API
- * and is intended for Windows platforms only.
+ * This server listens for incoming TCP connections on a specified port (8080 by
+ * default) and, on Linux, optionally on a Unix domain socket for clients on the
+ * same host. It accepts as many simultaneous clients as its profile allows (see
+ * ServerProfile.h), relays messages between them, and handles client
+ * disconnections. Sockets are reached through
+ * the transport layer (see Transport.h) and message handling lives in the relay
+ * engine (see RelayEngine.h), so this file only runs the select() loop.
  *
  * Key features:
  * - Accepts multiple client connections using select() for multiplexing.
  * - Broadcasts received messages to all connected clients except the sender.
  * - Cleans up resources and handles errors gracefully.
  * - Logs messages to a file with timestamps.
+ * - Optionally federates with other server nodes (see Federation.h), so users
+ *   connected to different nodes chat together and share one nickname space.
+ * - Messages are length-prefixed frames (see Framing.h); outgoing frames are
+ *   coalesced per client and written in bulk (see OutputBatcher.h).
+ * - Keeps messages for users who went offline on disk and delivers them when
+ *   they reconnect (see OfflineQueue.h).
+ * - Server console commands (/kick, /kickall, /mute, /unmute, /users, /who) that
+ *   never block the relay loop (see AdminControl.h).
+ * - Socket options, buffer sizes, batching, CPU affinity and logging come from a
+ *   runtime profile instead of compile-time constants (see ServerProfile.h).
  *
  * @author Nikita Struk
  * @date May 30, 2025
- * Last updated: June 18, 2025
+ * Last updated: October 18, 2026
  */
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#include <windows.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
-#include <fstream>
 #include <iostream>
-#include <iomanip>
-#include <chrono>
+#include <memory>
+#include <string>
 #include <thread>
-#include <map>
-#include <mutex>
+#include <vector>
 
-#pragma comment(lib, "ws2_32.lib")
+#include "AdminControl.h"
+#include "Federation.h"
+#include "OfflineQueue.h"
+#include "OutputBatcher.h"
+#include "RelayEngine.h"
+#include "ServerProfile.h"
+#include "Transport.h"
 
-#define PORT 8080
-#define MAX_CLIENTS 10
-#define BUFFER_SIZE 1024
+// Interval at which select() wakes up to keep peer links alive when federated, in milliseconds
+#define FEDERATION_TICK_MS 250
 
-
-
-void LogMessage(const char* message) 
+// Prints the users of the latest snapshot, optionally only those of one node
+void PrintUsers(const RelayEngine& engine, const std::string& node)
 {
-	std::ofstream logFile("server.log", std::ios::app);
-	if (logFile.is_open()) 
+	std::shared_ptr<const UserSnapshot> snapshot = engine.Users();
+	if (node.empty())
+		printf("Connected users:\n");
+	else
+		printf("Users on node '%s':\n", node.c_str());
+	size_t listed = 0;
+	for (const UserInfo& user : snapshot->users)
 	{
-		// Get current time as system time
-		auto now = std::chrono::system_clock::now();
-
-		// Convert system time to time_t
-		std::time_t currentTime = std::chrono::system_clock::to_time_t(now);
-
-		// Convert time_t to tm structure
-		std::tm localTime;
-		localtime_s(&localTime, &currentTime); // Use localtime_s for thread safety
-
-		// Log the message with timestamp
-		logFile << std::put_time(&localTime, "(%m/%d/%H:%M)") << " " << message << std::endl;
-		logFile.close();
-	} 
-	else 
-	{
-		printf("Could not open log file.\n");
+		if (!node.empty() && user.node != node)
+			continue;
+		printf("- %s (%s)%s\n", user.nickname.c_str(), user.node.c_str(), user.muted ? " [muted]" : "");
+		listed++;
 	}
+	if (listed == 0)
+		printf("(none)\n");
 }
 
-// Helper to trim whitespace
-
-std::string trim(const std::string& s) {
-
-	size_t start = s.find_first_not_of(" \t\r\n");
-
-	size_t end = s.find_last_not_of(" \t\r\n");
-
-	return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
-
-}
-
-
-
-void ServerConsoleThread(std::map<std::string, int>& nameToSocket, int clientSockets[], std::mutex& mapMutex) {
+void ServerConsoleThread(AdminQueue& admin, const RelayEngine& engine) {
 
 	while (true) {
 
 		std::string input;
 
-		std::getline(std::cin, input);
+		// No console (e.g. started by a script with stdin closed): nothing left to read
+		if (!std::getline(std::cin, input))
+			return;
 
 		input = trim(input);
 
-		if (input.rfind("/kick ", 0) == 0) 
+		AdminCommand command;
+		if (ParseAdminCommand(input, command))
+		{
+			// Runs on the relay loop; it prints the outcome
+			admin.Post(command);
+		}
+		else if (input == "/users" || input == "/who")
+		{
+			PrintUsers(engine, "");
+		}
+		else if (input.rfind("/who ", 0) == 0)
+		{
+			PrintUsers(engine, trim(input.substr(5)));
+		}
+		else if (!input.empty())
 		{
-			std::string clientName = trim(input.substr(6));
-			std::lock_guard<std::mutex> lock(mapMutex);
-			auto it = nameToSocket.find(clientName);
-			if (it != nameToSocket.end()) 
-			{
-				int sock = it->second;
-				send(sock, "You have been kicked by the server.", 35, 0);
-				closesocket(sock);
-				// Remove from clientSockets array
-				for (int i = 0; i < MAX_CLIENTS; ++i) 
-				{
-					if (clientSockets[i] == sock) 
-					{
-						clientSockets[i] = 0;
-						break;
-					}
-				}
-				nameToSocket.erase(it);
-				printf("Client '%s' has been kicked.\n", clientName.c_str());
-			}
-			else 
-			{
-				printf("No client with nickname '%s' found.\n", clientName.c_str());
-			}
+			printf("Commands: /kick <nickname>, /kickall, /mute <nickname>, /unmute <nickname>, /users, /who [node]\n");
 		}
 	}
 }
 
-void InitializeServer() {
-	WSADATA wsaData; // Winsock data structure
-	int serverFD, newSocket, clientSockets[MAX_CLIENTS]; // Array to hold client sockets
-	struct sockaddr_in address; // Structure to hold server address information
-	int opt = 1, maxSD, activity; // Variables for select() and activity checking
-	fd_set readfds; // File descriptor set for select()
-	char buffer[BUFFER_SIZE + 1] = { 0 }; // Buffer for incoming messages
-	int addrlen = sizeof(address); // Length of the address structure
+void InitializeServer(const ServerProfile& profile) {
+	int maxSD, activity; // Variables for select() and activity checking
+	fd_set readfds, writefds; // File descriptor sets for select()
 
-	// Map nickname to socket
-	std::map<std::string, int> nameToSocket;
-	std::mutex mapMutex;
-	// Start server console thread for /kick command
-	std::thread consoleThread(ServerConsoleThread, std::ref(nameToSocket), clientSockets, std::ref(mapMutex));
-	consoleThread.detach();
-	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) 
+	// Starts Winsock on Windows for as long as the server runs
+	std::unique_ptr<Transport> tcp = CreateTcpTransport();
+	std::unique_ptr<Listener> tcpListener = tcp->Listen(":" + std::to_string(profile.port), profile.backlog);
+	if (!tcpListener)
 	{
-		printf("WSAStartup failed\n");
 		exit(EXIT_FAILURE);
 	}
+	printf("Server listening on port %d...\n", profile.port);
 
-	// Initialize client sockets to 0
-	for (int clientIndex = 0; clientIndex < MAX_CLIENTS; clientIndex++) clientSockets[clientIndex] = 0;
-	// Create a socket for the server
-	if ((serverFD = socket(AF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET) 
+	// Same-host clients may use a Unix domain socket instead of TCP
+	std::unique_ptr<Transport> unixTransport;
+	std::unique_ptr<Listener> unixListener;
+	if (!profile.unixSocketPath.empty())
 	{
-		printf("Socket creation failed: %d\n", WSAGetLastError());
-		WSACleanup();
-		exit(EXIT_FAILURE);
+		unixTransport = CreateUnixTransport();
+		if (unixTransport)
+			unixListener = unixTransport->Listen(profile.unixSocketPath, profile.backlog);
+		if (!unixListener)
+		{
+			printf("Unix domain socket '%s' is not available\n", profile.unixSocketPath.c_str());
+			exit(EXIT_FAILURE);
+		}
+		printf("Server listening on Unix socket %s...\n", profile.unixSocketPath.c_str());
 	}
-	// Set socket options to allow reuse of the address
-	if (setsockopt(serverFD, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt)) < 0) 
+
+	Listener* listeners[] = { tcpListener.get(), unixListener.get() };
+	// Accepted client sockets inherit the kernel buffer sizes of their listener
+	if (profile.receiveBufferBytes > 0 || profile.sendBufferBytes > 0)
 	{
-		printf("setsockopt failed: %d\n", WSAGetLastError());
-		closesocket(serverFD);
-		WSACleanup();
-		exit(EXIT_FAILURE);
+		for (Listener* listener : listeners)
+		{
+			if (listener != nullptr && !listener->SetBufferSizes(profile.receiveBufferBytes, profile.sendBufferBytes))
+				printf("Could not set the socket buffer sizes: %d\n", SocketLastError());
+		}
 	}
 
-	address.sin_family = AF_INET;
-	address.sin_addr.s_addr = INADDR_ANY;
-	address.sin_port = htons(PORT);
-	// Bind the socket to the specified port
-	if (bind(serverFD, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR) 
+	// Links to the other nodes of the cluster; does nothing when no peer port was configured
+	FederationBus federation(profile.federation);
+	if (!federation.Start())
 	{
-		printf("Bind failed: %d\n", WSAGetLastError());
-		closesocket(serverFD);
-		WSACleanup();
 		exit(EXIT_FAILURE);
 	}
-	// Start listening for incoming connections
-	if (listen(serverFD, 3) == SOCKET_ERROR) 
+	std::vector<FederationEvent> federationEvents;
+
+	// Messages for users who are away, kept in the "offline" directory next to server.log by default
+	OfflineStore offline(profile.offline);
+	bool offlineEnabled = profile.offlineEnabled && offline.Open();
+	if (offlineEnabled)
 	{
-		printf("Listen failed: %d\n", WSAGetLastError());
-		closesocket(serverFD);
-		WSACleanup();
-		exit(EXIT_FAILURE);
+		printf("Offline message queue holds messages for %zu users\n", offline.RecipientCount());
 	}
+	else
+	{
+		printf("Offline message queue disabled\n");
+	}
+
+	// Outgoing frames per client, shared by the relay engine and the console thread
+	OutputBatcher batcher(profile.batching);
+	RelayEngine engine(federation, batcher, profile.relay, offlineEnabled ? &offline : nullptr);
+
+	// Start server console thread for the admin commands
+	AdminQueue admin;
+	std::thread consoleThread(ServerConsoleThread, std::ref(admin), std::cref(engine));
+	consoleThread.detach();
 
-	printf("Server listening on port %d...\n", PORT);
+	// Only the relay loop is pinned; the console thread started above keeps every CPU
+	if (profile.cpu >= 0)
+	{
+		if (PinCurrentThreadToCpu(profile.cpu))
+			printf("Relay loop pinned to CPU %d\n", profile.cpu);
+		else
+			printf("Could not pin the relay loop to CPU %d\n", profile.cpu);
+	}
 
-	while (1) 
+	while (1)
 	{
 		FD_ZERO(&readfds);
-		FD_SET(serverFD, &readfds);
-		maxSD = serverFD;
-		// Add client sockets to the set
-		for (int clientIndex = 0; clientIndex < MAX_CLIENTS; clientIndex++) 
+		FD_ZERO(&writefds);
+		maxSD = 0;
+		for (Listener* listener : listeners)
 		{
-			if (clientSockets[clientIndex] > 0)
-				FD_SET(clientSockets[clientIndex], &readfds);
-			if (clientSockets[clientIndex] > maxSD)
-				maxSD = clientSockets[clientIndex];
+			if (listener == nullptr)
+				continue;
+			FD_SET(listener->Handle(), &readfds);
+			if ((int)listener->Handle() > maxSD)
+				maxSD = (int)listener->Handle();
 		}
-
-		activity = select(0, &readfds, NULL, NULL, NULL); // 0 for nfds on Windows
+		// Wakes us up when the console posts a command
+		if (admin.WakeHandle() != INVALID_SOCKET)
+		{
+			FD_SET(admin.WakeHandle(), &readfds);
+			if ((int)admin.WakeHandle() > maxSD)
+				maxSD = (int)admin.WakeHandle();
+		}
+		// Add client sockets to the set, and those whose output waits for room in the socket
+		engine.AddToReadSet(readfds, maxSD);
+		engine.AddToWriteSet(writefds, maxSD);
+		federation.PrepareSelect(readfds, writefds, maxSD);
+
+		// Peer links need periodic attention (re-dialing), so never block forever when federated,
+		// and wake up in time to flush batched output whose window is about to expire
+		long long waitMicros = federation.IsEnabled() ? FEDERATION_TICK_MS * 1000LL : -1;
+		long long batchMicros = batcher.MicrosUntilDue();
+		if (batchMicros >= 0 && (waitMicros < 0 || batchMicros < waitMicros))
+			waitMicros = batchMicros;
+		// Without a wake-up descriptor, posted admin commands are only noticed by polling
+		if (admin.WakeHandle() == INVALID_SOCKET && (waitMicros < 0 || waitMicros > ADMIN_POLL_MS * 1000LL))
+			waitMicros = ADMIN_POLL_MS * 1000LL;
+		struct timeval timeout = { (long)(waitMicros / 1000000), (long)(waitMicros % 1000000) };
+		activity = select(maxSD + 1, &readfds, &writefds, NULL, waitMicros >= 0 ? &timeout : NULL); // nfds is ignored on Windows
 		// Check for errors in select
-		if (activity == SOCKET_ERROR) 
+		if (activity == SOCKET_ERROR)
 		{
-			printf("Select error: %d\n", WSAGetLastError());
+			printf("Select error: %d\n", SocketLastError());
 			break;
 		}
-		// Check if there is an incoming connection on the server socket
-		if (FD_ISSET(serverFD, &readfds)) {
-			if ((newSocket = accept(serverFD, (struct sockaddr*)&address, &addrlen)) == INVALID_SOCKET) 
-			{
-				printf("Accept failed: %d\n", WSAGetLastError());
-				break;
-			}
 
-			for (int clientIndex = 0; clientIndex < MAX_CLIENTS; clientIndex++) 
-			{
-				if (clientSockets[clientIndex] == 0) {
-					clientSockets[clientIndex] = newSocket;
-					printf("New connection, socket fd is %d, client index is %d\n", newSocket, clientIndex);
-					break;
-				}
-			}
-		}
-		// Check for incoming messages from clients
-		for (int clientIndex = 0; clientIndex < MAX_CLIENTS; clientIndex++) 
+		// Console commands run here, between two passes over the clients
+		if (admin.WakeHandle() != INVALID_SOCKET && FD_ISSET(admin.WakeHandle(), &readfds))
 		{
-			SOCKET s = clientSockets[clientIndex];
-			if (s > 0 && FD_ISSET(s, &readfds)) {
-				int valueRead = recv(s, buffer, BUFFER_SIZE, 0);
-				if (valueRead <= 0) 
-				{
-					getpeername(s, (struct sockaddr*)&address, &addrlen);
-					printf("Client disconnected, socket fd is %d, client index is %d\n", s, clientIndex);
-					closesocket(s);
-					clientSockets[clientIndex] = 0;
-				}
-				else 
-				{
-					buffer[valueRead] = '\0';
-
-					printf("%s\n", buffer);
-					LogMessage(buffer);
-					// Extract nickname (format: "nickname: message")
-					std::string msg(buffer);
-					size_t sep = msg.find(": ");
-
-					// Detect if the message is exactly "/users"
-					if (msg == "/users") {
-						std::lock_guard<std::mutex> lock(mapMutex);
-						std::string userList = "Connected users:";
-						if (nameToSocket.empty()) {
-							userList += " (none)";
-						}
-						else {
-							for (const auto& pair : nameToSocket) {
-								userList += "\n- " + pair.first;
-							}
-						}
-						send(s, userList.c_str(), (int)userList.length(), 0);
-						continue; // Do not broadcast this command
-					}
-
-					if (sep != std::string::npos) 
-					{
-						std::string nickname = msg.substr(0, sep);
-						std::string content = msg.substr(sep + 2);
-
-						//Detect nickname change pattern: "<oldNickname> changed to <newNickname>"
-						std::string nickChangePrefix = " changed to ";
-						size_t nickChangePos = content.find(nickChangePrefix);
-						if (nickChangePos == 0)
-						{
-							std::string newNickname = content.substr(nickChangePrefix.length());
-							newNickname = trim(newNickname);
-							std::lock_guard <std::mutex> lock(mapMutex);
-							//Check if the new nickname is already taken
-							if(nameToSocket.find(newNickname) != nameToSocket.end()) 
-							{
-								std::string errorMsg = "Nickname '" + newNickname + "' is already taken.";
-								send(s, errorMsg.c_str(), (int)errorMsg.length(), 0);
-								continue; // Skip further processing for this message
-							}
-							else
-							{
-								// Update the nickname in the map
-								nameToSocket.erase(nickname);
-								nameToSocket[newNickname] = s;
-
-								//Broadcast the nickname change to all clients
-								std::string announceMsg = nickname + " changed nickname to " + newNickname;
-								for (int i = 0; i < MAX_CLIENTS; i++) 
-								{
-									if (clientSockets[i] > 0) 
-									{
-										send(clientSockets[i], announceMsg.c_str(), (int)announceMsg.length(), 0);
-									}
-								}
-								LogMessage(announceMsg.c_str());
-							}
-							continue; // Skip normal message broadcast
-						}
+			admin.ClearWake();
+		}
+		engine.ProcessAdmin(admin);
 
-						std::lock_guard<std::mutex> lock(mapMutex);
-						nameToSocket[nickname] = s;
-					}
-					for (int i = 0; i < MAX_CLIENTS; i++) 
-					{
-						if (clientSockets[i] > 0 && i != clientIndex) 
-						{
-							send(clientSockets[i], buffer, valueRead, 0);
-							LogMessage(buffer); // Log the message to server.log
-						}
-					}
-				}
-			}
+		// Deliver what other nodes sent us before serving local clients
+		federationEvents.clear();
+		federation.ProcessSelect(readfds, writefds, federationEvents);
+		for (const FederationEvent& event : federationEvents)
+		{
+			engine.OnFederationEvent(event);
+		}
+		// Check if there is an incoming connection on a listening socket
+		for (Listener* listener : listeners)
+		{
+			if (listener == nullptr || !FD_ISSET(listener->Handle(), &readfds))
+				continue;
+			std::unique_ptr<Connection> connection = listener->Accept();
+			if (!connection)
+				continue;
+			int socketFD = (int)connection->Handle();
+			int clientIndex = engine.AddClient(std::move(connection));
+			if (clientIndex >= 0 && profile.relay.echoEvents)
+				printf("New connection, socket fd is %d, client index is %d\n", socketFD, clientIndex);
+			else if (clientIndex < 0)
+				printf("Server is full, connection refused\n");
 		}
+		// Check for incoming messages from clients
+		engine.ProcessReadSet(readfds);
+
+		// Resume clients whose socket has room again, then write out batches whose window expired
+		// (all of them when the window is 0)
+		engine.ProcessWriteSet(writefds);
+		batcher.FlushDue();
+		// Clients whose socket failed or that let too much output pile up
+		engine.DropBrokenClients();
+		// One write per peer link for everything queued during this pass
+		federation.Flush();
+		// Hand the offline lines logged during this pass to the operating system
+		offline.Sync();
+		// Let /users and /who see the nicknames claimed or released during this pass
+		engine.RefreshUsers();
 	}
-
-	closesocket(serverFD);
-	WSACleanup();
-}
\ No newline at end of file
+}
@@ -0,0 +1,426 @@
+/**
+ * @file ServerProfile.cpp
+ * @brief Parsing, validation and printing of server profiles.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "ServerProfile.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <fstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+	// Values a size suffix may not push past, so the multiplication cannot overflow
+	const long long MAX_UNSCALED = 1LL << 40;
+
+	bool ParseInteger(const std::string& text, long long minimum, long long maximum, bool sizeSuffix,
+					  long long& value, std::string& error)
+	{
+		const char* begin = text.c_str();
+		char* end = nullptr;
+		errno = 0;
+		long long parsed = strtoll(begin, &end, 10);
+		bool valid = end != begin && errno != ERANGE && parsed >= -MAX_UNSCALED && parsed <= MAX_UNSCALED;
+		if (valid && sizeSuffix && (*end == 'k' || *end == 'K'))
+		{
+			parsed *= 1024;
+			end++;
+		}
+		else if (valid && sizeSuffix && (*end == 'm' || *end == 'M'))
+		{
+			parsed *= 1024 * 1024;
+			end++;
+		}
+		if (!valid || *end != '\0' || parsed < minimum || parsed > maximum)
+		{
+			error = "'" + text + "' is not a number from " + std::to_string(minimum) + " to " + std::to_string(maximum);
+			if (sizeSuffix)
+				error += " (k and m suffixes allowed)";
+			return false;
+		}
+		value = parsed;
+		return true;
+	}
+
+	bool ParseSwitch(const std::string& text, bool& value, std::string& error)
+	{
+		if (text == "on" || text == "true" || text == "yes" || text == "1")
+			value = true;
+		else if (text == "off" || text == "false" || text == "no" || text == "0")
+			value = false;
+		else
+		{
+			error = "'" + text + "' is not on or off";
+			return false;
+		}
+		return true;
+	}
+
+	const char* SwitchName(bool value)
+	{
+		return value ? "on" : "off";
+	}
+
+	struct SettingInfo
+	{
+		const char* key;
+		const char* help;
+		bool (*apply)(ServerProfile& profile, const std::string& value, std::string& error);
+		std::string (*print)(const ServerProfile& profile);
+	};
+
+	const SettingInfo settingTable[] = {
+		{ "port", "TCP port for clients",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 1, 65535, false, n, e))
+					return false;
+				p.port = (unsigned short)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.port); } },
+		{ "unix-socket", "Unix domain socket path for clients on this host, empty for none",
+			[](ServerProfile& p, const std::string& v, std::string&) { p.unixSocketPath = v; return true; },
+			[](const ServerProfile& p) { return p.unixSocketPath; } },
+		{ "backlog", "connections waiting to be accepted (listen() backlog)",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 1, 65535, false, n, e))
+					return false;
+				p.backlog = (int)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.backlog); } },
+		{ "max-clients", "client slots; further connections are refused",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 1, MAX_PROFILE_CLIENTS, false, n, e))
+					return false;
+				p.relay.maxClients = (int)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.relay.maxClients); } },
+		{ "read-buffer", "bytes read from a client per call",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 64, 16 * 1024 * 1024, true, n, e))
+					return false;
+				p.relay.readBufferSize = (size_t)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.relay.readBufferSize); } },
+		{ "so-rcvbuf", "kernel receive buffer of client sockets (SO_RCVBUF), 0 for the system default",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 0, 256 * 1024 * 1024, true, n, e))
+					return false;
+				p.receiveBufferBytes = (int)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.receiveBufferBytes); } },
+		{ "so-sndbuf", "kernel send buffer of client sockets (SO_SNDBUF), 0 for the system default",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 0, 256 * 1024 * 1024, true, n, e))
+					return false;
+				p.sendBufferBytes = (int)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.sendBufferBytes); } },
+		{ "tcp-nodelay", "TCP_NODELAY on client sockets and TCP_CORK around large flushes (on/off)",
+			[](ServerProfile& p, const std::string& v, std::string& e) { return ParseSwitch(v, p.batching.tuneSockets, e); },
+			[](const ServerProfile& p) { return std::string(SwitchName(p.batching.tuneSockets)); } },
+		{ "batch-window-us", "time queued output may wait for more, 0 flushes after every loop pass",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 0, 1000000, false, n, e))
+					return false;
+				p.batching.windowMicros = (unsigned int)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.batching.windowMicros); } },
+		{ "batch-bytes", "queued bytes that force a flush",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 1, 64 * 1024 * 1024, true, n, e))
+					return false;
+				p.batching.byteBudget = (size_t)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.batching.byteBudget); } },
+		{ "client-backlog", "unsent bytes a client may pile up before it is disconnected, 0 for no limit",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 0, 1024LL * 1024 * 1024, true, n, e))
+					return false;
+				p.batching.maxQueuedBytes = (size_t)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.batching.maxQueuedBytes); } },
+		{ "cpu", "CPU the relay loop is pinned to, -1 for none",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, -1, 1023, false, n, e))
+					return false;
+				p.cpu = (int)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.cpu); } },
+		{ "log", "where messages go: both, file (server.log), console or none",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				bool file = v == "both" || v == "file";
+				bool console = v == "both" || v == "console";
+				if (!file && !console && v != "none")
+				{
+					e = "'" + v + "' is not both, file, console or none";
+					return false;
+				}
+				p.relay.logMessages = file;
+				p.relay.echoMessages = console;
+				return true;
+			},
+			[](const ServerProfile& p)
+			{
+				if (p.relay.logMessages)
+					return std::string(p.relay.echoMessages ? "both" : "file");
+				return std::string(p.relay.echoMessages ? "console" : "none");
+			} },
+		{ "events", "print connections, disconnections and the outcome of admin commands (on/off)",
+			[](ServerProfile& p, const std::string& v, std::string& e) { return ParseSwitch(v, p.relay.echoEvents, e); },
+			[](const ServerProfile& p) { return std::string(SwitchName(p.relay.echoEvents)); } },
+		{ "offline", "keep messages for users who are away (on/off)",
+			[](ServerProfile& p, const std::string& v, std::string& e) { return ParseSwitch(v, p.offlineEnabled, e); },
+			[](const ServerProfile& p) { return std::string(SwitchName(p.offlineEnabled)); } },
+		{ "offline-dir", "directory of the offline message queue",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				if (v.empty())
+				{
+					e = "the directory cannot be empty";
+					return false;
+				}
+				p.offline.directory = v;
+				return true;
+			},
+			[](const ServerProfile& p) { return p.offline.directory; } },
+		{ "offline-max-bytes", "queued bytes kept per absent user",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 1024, 1024LL * 1024 * 1024, true, n, e))
+					return false;
+				p.offline.maxBytesPerUser = (size_t)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.offline.maxBytesPerUser); } },
+		{ "offline-max-users", "absent users queued for at once, the one away longest is dropped beyond it; 0 for no limit",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 0, 1000000, false, n, e))
+					return false;
+				p.offline.maxRecipients = (size_t)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.offline.maxRecipients); } },
+		{ "offline-ttl-s", "seconds an absent user's queue is kept, 0 for no limit",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 0, 365LL * 24 * 60 * 60, false, n, e))
+					return false;
+				p.offline.recipientTtlSeconds = (unsigned int)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.offline.recipientTtlSeconds); } },
+		{ "peer-port", "port for links from other server nodes, 0 runs standalone",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				long long n;
+				if (!ParseInteger(v, 0, 65535, false, n, e))
+					return false;
+				p.federation.peerPort = (unsigned short)n;
+				return true;
+			},
+			[](const ServerProfile& p) { return std::to_string(p.federation.peerPort); } },
+		{ "node", "name of this node in a federation (default node-<peer-port>)",
+			[](ServerProfile& p, const std::string& v, std::string&) { p.federation.nodeId = v; return true; },
+			[](const ServerProfile& p) { return p.federation.nodeId; } },
+		{ "peers", "nodes to dial, host:port[,host:port...]",
+			[](ServerProfile& p, const std::string& v, std::string& e)
+			{
+				p.federation.peers.clear();
+				if (!ParsePeerList(v, p.federation.peers))
+				{
+					e = "'" + v + "' is not a host:port[,host:port...] list";
+					return false;
+				}
+				return true;
+			},
+			[](const ServerProfile& p)
+			{
+				std::string list;
+				for (const PeerAddress& peer : p.federation.peers)
+					list += (list.empty() ? "" : ",") + peer.host + ":" + std::to_string(peer.port);
+				return list;
+			} },
+	};
+}
+
+bool ApplyServerSetting(ServerProfile& profile, const std::string& key, const std::string& value, std::string& error)
+{
+	for (const SettingInfo& info : settingTable)
+	{
+		if (key != info.key)
+			continue;
+		std::string reason;
+		if (info.apply(profile, value, reason))
+			return true;
+		error = key + ": " + reason;
+		return false;
+	}
+	error = "unknown setting '" + key + "'";
+	return false;
+}
+
+bool LoadSettingsFile(const std::string& path, std::vector<Setting>& settings, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		error = "cannot read config file '" + path + "'";
+		return false;
+	}
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		line = trim(line);
+		if (line.empty() || line[0] == '#')
+			continue;
+		size_t equals = line.find('=');
+		if (equals == std::string::npos || equals == 0)
+		{
+			error = path + ":" + std::to_string(lineNumber) + ": expected key = value";
+			return false;
+		}
+		settings.push_back(Setting(trim(line.substr(0, equals)), trim(line.substr(equals + 1))));
+	}
+	return true;
+}
+
+bool ParseSettingArguments(int argc, char** argv, int first, std::vector<Setting>& settings, std::string& error)
+{
+	for (int i = first; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument.compare(0, 2, "--") != 0 || argument.size() == 2)
+		{
+			error = "unexpected argument '" + argument + "'";
+			return false;
+		}
+		size_t equals = argument.find('=');
+		if (equals != std::string::npos)
+			settings.push_back(Setting(argument.substr(2, equals - 2), argument.substr(equals + 1)));
+		else if (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0)
+			settings.push_back(Setting(argument.substr(2), argv[++i]));
+		else
+			settings.push_back(Setting(argument.substr(2), "on"));
+	}
+	return true;
+}
+
+bool LoadServerProfile(int argc, char** argv, int first, ServerProfile& profile, std::string& error)
+{
+	std::vector<Setting> arguments;
+	if (!ParseSettingArguments(argc, argv, first, arguments, error))
+		return false;
+
+	// Config files first, whatever their position, so the other arguments override them
+	std::vector<Setting> settings;
+	for (const Setting& argument : arguments)
+	{
+		if (argument.first == "config" && !LoadSettingsFile(argument.second, settings, error))
+			return false;
+	}
+	for (const Setting& argument : arguments)
+	{
+		if (argument.first != "config")
+			settings.push_back(argument);
+	}
+	for (const Setting& setting : settings)
+	{
+		if (!ApplyServerSetting(profile, setting.first, setting.second, error))
+			return false;
+	}
+
+	if (profile.federation.peerPort == 0 && !profile.federation.peers.empty())
+	{
+		error = "peers: a standalone server (peer-port 0) cannot dial other nodes";
+		return false;
+	}
+	// A returning user gets its whole offline queue at once; less room than that would only cut it off
+	if (profile.offlineEnabled && profile.batching.maxQueuedBytes > 0 &&
+		profile.batching.maxQueuedBytes < profile.offline.maxBytesPerUser)
+	{
+		error = "client-backlog: must be 0 or at least offline-max-bytes (" +
+				std::to_string(profile.offline.maxBytesPerUser) + ")";
+		return false;
+	}
+	if (profile.federation.peerPort > 0 && profile.federation.nodeId.empty())
+		profile.federation.nodeId = "node-" + std::to_string(profile.federation.peerPort);
+	return true;
+}
+
+void PrintServerProfile(const ServerProfile& profile, FILE* out)
+{
+	for (const SettingInfo& info : settingTable)
+		fprintf(out, "%s = %s\n", info.key, info.print(profile).c_str());
+}
+
+void PrintServerSettingsHelp(FILE* out)
+{
+	fprintf(out, "  --%-18s %s\n", "config <file>", "read settings from a file of key = value lines first");
+	for (const SettingInfo& info : settingTable)
+		fprintf(out, "  --%-18s %s\n", info.key, info.help);
+}
+
+bool PinCurrentThreadToCpu(int cpu)
+{
+#if defined(__linux__)
+	if (cpu < 0 || cpu >= CPU_SETSIZE)
+		return false;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+	if (cpu < 0 || cpu >= (int)(sizeof(DWORD_PTR) * 8))
+		return false;
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
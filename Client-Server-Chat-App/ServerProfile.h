@@ -0,0 +1,104 @@
+#pragma once
+/**
+ * @file ServerProfile.h
+ * @brief Runtime settings of the server, read from the command line and a config file.
+ *
+ * A profile gathers everything that can be tuned per deployment without
+ * rebuilding: listening endpoints and backlog, client slots and read buffer
+ * size, kernel socket buffers, TCP_NODELAY and output batching, CPU affinity
+ * of the relay loop, what gets logged, the offline queue and federation.
+ *
+ * Settings are "key = value" lines in a config file ('#' starts a comment) or
+ * "--key value" / "--key=value" arguments; arguments override the file. Sizes
+ * accept a k or m suffix (KiB, MiB) and switches accept on/off. Run the server
+ * with --help for the list of keys; PrintServerProfile() writes the effective
+ * settings in the config file format, so its output can be saved as a config.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Federation.h"
+#include "OfflineQueue.h"
+#include "OutputBatcher.h"
+#include "RelayEngine.h"
+
+#include <stdio.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Port of the chat server unless the profile says otherwise
+#define DEFAULT_SERVER_PORT 8080
+
+// Default length of the queue of connections waiting to be accepted
+#define DEFAULT_LISTEN_BACKLOG 3
+
+// Most client slots a profile may ask for; the rest of a select() set is left
+// to the listeners, the admin wake-up descriptor and federation links
+#define MAX_PROFILE_CLIENTS (FD_SETSIZE - 16)
+
+/**
+ * @brief One "key = value" setting, before it is applied.
+ */
+typedef std::pair<std::string, std::string> Setting;
+
+/**
+ * @brief Everything the server loop needs to start.
+ */
+struct ServerProfile
+{
+	unsigned short port = DEFAULT_SERVER_PORT;
+	std::string unixSocketPath; // Empty: no Unix domain socket
+	int backlog = DEFAULT_LISTEN_BACKLOG;
+	int receiveBufferBytes = 0; // SO_RCVBUF of client sockets, 0 keeps the system default
+	int sendBufferBytes = 0;    // SO_SNDBUF of client sockets, 0 keeps the system default
+	int cpu = -1;               // CPU the relay loop is pinned to, -1 for none
+	bool offlineEnabled = true;
+	RelayOptions relay;
+	BatchingOptions batching;
+	OfflineOptions offline;
+	FederationOptions federation;
+};
+
+/**
+ * @brief Applies one setting to a profile.
+ * @return false with a message in error if the key is unknown or the value invalid.
+ */
+bool ApplyServerSetting(ServerProfile& profile, const std::string& key, const std::string& value, std::string& error);
+
+/**
+ * @brief Reads the "key = value" lines of a config file.
+ * @return false with a message in error if the file cannot be read or a line is malformed.
+ */
+bool LoadSettingsFile(const std::string& path, std::vector<Setting>& settings, std::string& error);
+
+/**
+ * @brief Splits "--key value" and "--key=value" arguments, starting at argv[first].
+ *
+ * A "--key" followed by another option or by nothing is read as "key = on".
+ * @return false with a message in error on an argument that is not an option.
+ */
+bool ParseSettingArguments(int argc, char** argv, int first, std::vector<Setting>& settings, std::string& error);
+
+/**
+ * @brief Builds a profile from the defaults, the file named by --config (if any) and the other arguments.
+ * @return false with a message in error on the first invalid setting.
+ */
+bool LoadServerProfile(int argc, char** argv, int first, ServerProfile& profile, std::string& error);
+
+/**
+ * @brief Writes the effective settings of a profile as config file lines.
+ */
+void PrintServerProfile(const ServerProfile& profile, FILE* out);
+
+/**
+ * @brief Writes the known keys with a short description of each.
+ */
+void PrintServerSettingsHelp(FILE* out);
+
+/**
+ * @brief Restricts the calling thread to one CPU.
+ * @return false if the CPU does not exist or affinity is not supported here.
+ */
+bool PinCurrentThreadToCpu(int cpu);
@@ -0,0 +1,179 @@
+#pragma once
+/**
+ * @file SocketCompat.h
+ * @brief Small portability layer over Winsock2 and BSD sockets.
+ *
+ * Lets socket code that does not depend on Windows-only behaviour build on both
+ * Windows and Linux, so multi-node setups can be exercised over loopback on
+ * either platform.
+ *
+ * Also wraps the few TCP knobs the output batching layer and the server profile
+ * rely on: gathered writes (WSASend / sendmsg), TCP_NODELAY, SO_RCVBUF /
+ * SO_SNDBUF and, where it exists, TCP_CORK.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+// windows.h (pulled in by winsock2.h) must not define min/max macros over std::min/std::max
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#pragma comment(lib, "ws2_32.lib")
+
+typedef SOCKET socket_t;
+
+// Flags passed to every send() (Winsock never raises SIGPIPE)
+#define SOCKET_SEND_FLAGS 0
+
+// Most buffers handed to one gathered write
+#define SOCKET_MAX_GATHER 1024
+
+inline int SocketLastError() { return WSAGetLastError(); }
+
+// True if a non-blocking call failed only because it would have to wait
+inline bool SocketWouldBlock(int err) { return err == WSAEWOULDBLOCK; }
+
+// True if a non-blocking connect() has been started and is still running
+inline bool SocketConnectPending(int err) { return err == WSAEWOULDBLOCK || err == WSAEINPROGRESS; }
+
+inline bool SetSocketNonBlocking(socket_t s)
+{
+	u_long mode = 1;
+	return ioctlsocket(s, FIONBIO, &mode) == 0;
+}
+
+#else
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+typedef int socket_t;
+
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET (-1)
+#endif
+#ifndef SOCKET_ERROR
+#define SOCKET_ERROR (-1)
+#endif
+
+// Flags passed to every send(): a peer that went away must not kill the process
+#define SOCKET_SEND_FLAGS MSG_NOSIGNAL
+
+// Most buffers handed to one gathered write (IOV_MAX on Linux)
+#define SOCKET_MAX_GATHER 1024
+
+inline int closesocket(socket_t s) { return close(s); }
+
+inline int SocketLastError() { return errno; }
+
+inline bool SocketWouldBlock(int err) { return err == EAGAIN || err == EWOULDBLOCK; }
+
+inline bool SocketConnectPending(int err) { return err == EINPROGRESS; }
+
+inline bool SetSocketNonBlocking(socket_t s)
+{
+	int flags = fcntl(s, F_GETFL, 0);
+	return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+#endif
+
+/**
+ * @brief One piece of a gathered write.
+ */
+struct ConstBuffer
+{
+	const char* data;
+	size_t length;
+};
+
+inline bool SetSocketNoDelay(socket_t s, bool enabled)
+{
+	int opt = enabled ? 1 : 0;
+	return setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&opt, sizeof(opt)) == 0;
+}
+
+/**
+ * @brief Sets the kernel receive and send buffer sizes (SO_RCVBUF / SO_SNDBUF); 0 keeps the current size.
+ */
+inline bool SetSocketBufferSizes(socket_t s, int receiveBytes, int sendBytes)
+{
+	bool ok = true;
+	if (receiveBytes > 0)
+		ok = setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&receiveBytes, sizeof(receiveBytes)) == 0;
+	if (sendBytes > 0)
+		ok = setsockopt(s, SOL_SOCKET, SO_SNDBUF, (const char*)&sendBytes, sizeof(sendBytes)) == 0 && ok;
+	return ok;
+}
+
+/**
+ * @brief Holds back partial segments until uncorked (TCP_CORK).
+ * @return false where the option does not exist (Windows), so callers can skip the uncork.
+ */
+inline bool SetSocketCork(socket_t s, bool enabled)
+{
+#ifdef TCP_CORK
+	int opt = enabled ? 1 : 0;
+	return setsockopt(s, IPPROTO_TCP, TCP_CORK, (const char*)&opt, sizeof(opt)) == 0;
+#else
+	(void)s;
+	(void)enabled;
+	return false;
+#endif
+}
+
+/**
+ * @brief Writes several buffers with a single system call.
+ * @return Bytes written, or SOCKET_ERROR.
+ */
+inline long SocketSendV(socket_t s, const ConstBuffer* buffers, size_t count)
+{
+	if (count > SOCKET_MAX_GATHER)
+		count = SOCKET_MAX_GATHER;
+#ifdef _WIN32
+	WSABUF wsaBuffers[SOCKET_MAX_GATHER];
+	for (size_t i = 0; i < count; i++)
+	{
+		wsaBuffers[i].buf = (CHAR*)buffers[i].data;
+		wsaBuffers[i].len = (ULONG)buffers[i].length;
+	}
+	DWORD sent = 0;
+	if (WSASend(s, wsaBuffers, (DWORD)count, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+		return SOCKET_ERROR;
+	return (long)sent;
+#else
+	// sendmsg() is writev() plus flags, which keeps MSG_NOSIGNAL
+	struct iovec iov[SOCKET_MAX_GATHER];
+	for (size_t i = 0; i < count; i++)
+	{
+		iov[i].iov_base = (void*)buffers[i].data;
+		iov[i].iov_len = buffers[i].length;
+	}
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = iov;
+	message.msg_iovlen = count;
+	return (long)sendmsg(s, &message, SOCKET_SEND_FLAGS);
+#endif
+}
@@ -0,0 +1,533 @@
+/**
+ * @file Transport.cpp
+ * @brief TCP, Unix domain socket and in-memory loopback transports.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Transport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#ifndef _WIN32
+#include <sys/un.h>
+#endif
+
+namespace
+{
+	// Connection over a socket descriptor, shared by the TCP and Unix backends
+	class SocketConnection : public Connection
+	{
+	public:
+		SocketConnection(socket_t sock, bool tcp) : sock(sock), tcp(tcp) {}
+		~SocketConnection() override { Close(); }
+
+		long Recv(char* buffer, size_t length) override
+		{
+			long result = recv(sock, buffer, (int)length, 0);
+			lastError = result == SOCKET_ERROR ? SocketLastError() : 0;
+			return result;
+		}
+
+		long Send(const char* data, size_t length) override
+		{
+			long result = send(sock, data, (int)length, SOCKET_SEND_FLAGS);
+			lastError = result == SOCKET_ERROR ? SocketLastError() : 0;
+			return result;
+		}
+
+		long SendV(const ConstBuffer* buffers, size_t count) override
+		{
+			long result = SocketSendV(sock, buffers, count);
+			lastError = result == SOCKET_ERROR ? SocketLastError() : 0;
+			return result;
+		}
+
+		bool WouldBlock() const override { return SocketWouldBlock(lastError); }
+
+		bool SetNonBlocking() override { return SetSocketNonBlocking(sock); }
+
+		bool SetNoDelay(bool enabled) override { return tcp && SetSocketNoDelay(sock, enabled); }
+
+		bool SetCork(bool enabled) override { return tcp && SetSocketCork(sock, enabled); }
+
+		bool SetBufferSizes(int receiveBytes, int sendBytes) override
+		{
+			return SetSocketBufferSizes(sock, receiveBytes, sendBytes);
+		}
+
+		socket_t Handle() const override { return sock; }
+
+		void Shutdown() override
+		{
+			if (sock != INVALID_SOCKET)
+			{
+#ifdef _WIN32
+				shutdown(sock, SD_BOTH);
+#else
+				shutdown(sock, SHUT_RDWR);
+#endif
+			}
+		}
+
+		void Close() override
+		{
+			if (sock != INVALID_SOCKET)
+			{
+				closesocket(sock);
+				sock = INVALID_SOCKET;
+			}
+		}
+
+	private:
+		socket_t sock;
+		bool tcp;
+		int lastError = 0;
+	};
+
+	class SocketListener : public Listener
+	{
+	public:
+		SocketListener(socket_t sock, bool tcp) : sock(sock), tcp(tcp) {}
+		~SocketListener() override { Close(); }
+
+		std::unique_ptr<Connection> Accept() override
+		{
+			socket_t client = accept(sock, nullptr, nullptr);
+			if (client == INVALID_SOCKET)
+			{
+				printf("Accept failed: %d\n", SocketLastError());
+				return nullptr;
+			}
+			return std::unique_ptr<Connection>(new SocketConnection(client, tcp));
+		}
+
+		bool SetBufferSizes(int receiveBytes, int sendBytes) override
+		{
+			return SetSocketBufferSizes(sock, receiveBytes, sendBytes);
+		}
+
+		socket_t Handle() const override { return sock; }
+
+		void Close() override
+		{
+			if (sock != INVALID_SOCKET)
+			{
+				closesocket(sock);
+				sock = INVALID_SOCKET;
+			}
+		}
+
+	private:
+		socket_t sock;
+		bool tcp;
+	};
+
+	// Splits "host:port"; an empty host or "*" means every interface
+	bool ParseHostPort(const std::string& endpoint, std::string& host, std::string& port)
+	{
+		size_t colon = endpoint.rfind(':');
+		if (colon == std::string::npos || colon + 1 == endpoint.size())
+			return false;
+		host = endpoint.substr(0, colon);
+		port = endpoint.substr(colon + 1);
+		if (host == "*")
+			host.clear();
+		int number = atoi(port.c_str());
+		return number > 0 && number <= 65535;
+	}
+
+	bool ResolveTcp(const std::string& endpoint, bool passive, struct sockaddr_in& address)
+	{
+		std::string host, port;
+		if (!ParseHostPort(endpoint, host, port))
+		{
+			printf("Invalid address '%s' (expected host:port)\n", endpoint.c_str());
+			return false;
+		}
+		struct addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = passive ? AI_PASSIVE : 0;
+		struct addrinfo* result = nullptr;
+		if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr)
+		{
+			printf("Invalid address '%s'\n", endpoint.c_str());
+			return false;
+		}
+		memcpy(&address, result->ai_addr, sizeof(address));
+		freeaddrinfo(result);
+		return true;
+	}
+
+	class TcpTransport : public Transport
+	{
+	public:
+		TcpTransport()
+		{
+#ifdef _WIN32
+			WSADATA wsaData;
+			started = WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+			if (!started)
+				printf("WSAStartup failed\n");
+#endif
+		}
+
+		~TcpTransport() override
+		{
+#ifdef _WIN32
+			if (started)
+				WSACleanup();
+#endif
+		}
+
+		std::unique_ptr<Listener> Listen(const std::string& endpoint, int backlog) override
+		{
+			struct sockaddr_in address;
+			if (!ResolveTcp(endpoint, true, address))
+				return nullptr;
+			socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+			if (sock == INVALID_SOCKET)
+			{
+				printf("Socket creation failed: %d\n", SocketLastError());
+				return nullptr;
+			}
+			// Allow reuse of the address
+			int opt = 1;
+			if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt)) < 0)
+			{
+				printf("setsockopt failed: %d\n", SocketLastError());
+				closesocket(sock);
+				return nullptr;
+			}
+			if (bind(sock, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR)
+			{
+				printf("Bind failed: %d\n", SocketLastError());
+				closesocket(sock);
+				return nullptr;
+			}
+			if (listen(sock, backlog) == SOCKET_ERROR)
+			{
+				printf("Listen failed: %d\n", SocketLastError());
+				closesocket(sock);
+				return nullptr;
+			}
+			return std::unique_ptr<Listener>(new SocketListener(sock, true));
+		}
+
+		std::unique_ptr<Connection> Connect(const std::string& endpoint) override
+		{
+			struct sockaddr_in address;
+			if (!ResolveTcp(endpoint, false, address))
+				return nullptr;
+			socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+			if (sock == INVALID_SOCKET)
+			{
+				printf("Socket creation failed: %d\n", SocketLastError());
+				return nullptr;
+			}
+			if (connect(sock, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR)
+			{
+				closesocket(sock);
+				return nullptr;
+			}
+			return std::unique_ptr<Connection>(new SocketConnection(sock, true));
+		}
+
+		const char* Name() const override { return "tcp"; }
+
+	private:
+		bool started = true;
+	};
+
+#ifndef _WIN32
+	bool MakeUnixAddress(const std::string& path, struct sockaddr_un& address)
+	{
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (path.empty() || path.size() >= sizeof(address.sun_path))
+		{
+			printf("Invalid Unix socket path '%s'\n", path.c_str());
+			return false;
+		}
+		memcpy(address.sun_path, path.c_str(), path.size() + 1);
+		return true;
+	}
+
+	class UnixTransport : public Transport
+	{
+	public:
+		std::unique_ptr<Listener> Listen(const std::string& endpoint, int backlog) override
+		{
+			struct sockaddr_un address;
+			if (!MakeUnixAddress(endpoint, address))
+				return nullptr;
+			socket_t sock = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (sock == INVALID_SOCKET)
+			{
+				printf("Socket creation failed: %d\n", SocketLastError());
+				return nullptr;
+			}
+			// A socket file left behind by an earlier run would make bind() fail
+			unlink(endpoint.c_str());
+			if (bind(sock, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR)
+			{
+				printf("Bind failed: %d\n", SocketLastError());
+				closesocket(sock);
+				return nullptr;
+			}
+			if (listen(sock, backlog) == SOCKET_ERROR)
+			{
+				printf("Listen failed: %d\n", SocketLastError());
+				closesocket(sock);
+				return nullptr;
+			}
+			return std::unique_ptr<Listener>(new SocketListener(sock, false));
+		}
+
+		std::unique_ptr<Connection> Connect(const std::string& endpoint) override
+		{
+			struct sockaddr_un address;
+			if (!MakeUnixAddress(endpoint, address))
+				return nullptr;
+			socket_t sock = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (sock == INVALID_SOCKET)
+				return nullptr;
+			if (connect(sock, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR)
+			{
+				closesocket(sock);
+				return nullptr;
+			}
+			return std::unique_ptr<Connection>(new SocketConnection(sock, false));
+		}
+
+		const char* Name() const override { return "unix"; }
+	};
+#endif
+
+	// One direction of an in-memory connection
+	struct LoopbackPipe
+	{
+		std::mutex mutex;
+		std::condition_variable readable;
+		std::string data;
+		size_t offset = 0; // Bytes of data already read
+		bool closed = false;
+	};
+
+	class LoopbackConnection : public Connection
+	{
+	public:
+		LoopbackConnection(const std::shared_ptr<LoopbackPipe>& in, const std::shared_ptr<LoopbackPipe>& out)
+			: in(in), out(out) {}
+		~LoopbackConnection() override { Close(); }
+
+		long Recv(char* buffer, size_t length) override
+		{
+			std::unique_lock<std::mutex> lock(in->mutex);
+			if (nonBlocking && in->offset == in->data.size() && !in->closed)
+			{
+				wouldBlock = true;
+				return SOCKET_ERROR;
+			}
+			in->readable.wait(lock, [this]() { return in->offset < in->data.size() || in->closed; });
+			wouldBlock = false;
+			size_t available = in->data.size() - in->offset;
+			if (available == 0)
+				return 0;
+			size_t count = length < available ? length : available;
+			memcpy(buffer, in->data.data() + in->offset, count);
+			in->offset += count;
+			if (in->offset == in->data.size())
+			{
+				in->data.clear();
+				in->offset = 0;
+			}
+			return (long)count;
+		}
+
+		long Send(const char* data, size_t length) override
+		{
+			ConstBuffer buffer = { data, length };
+			return SendV(&buffer, 1);
+		}
+
+		long SendV(const ConstBuffer* buffers, size_t count) override
+		{
+			std::lock_guard<std::mutex> lock(out->mutex);
+			wouldBlock = false;
+			if (out->closed)
+				return SOCKET_ERROR;
+			// Reclaim the consumed prefix once it is at least half of the buffer
+			if (out->offset > 0 && out->offset >= out->data.size() / 2)
+			{
+				out->data.erase(0, out->offset);
+				out->offset = 0;
+			}
+			size_t total = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				out->data.append(buffers[i].data, buffers[i].length);
+				total += buffers[i].length;
+			}
+			out->readable.notify_one();
+			return (long)total;
+		}
+
+		bool WouldBlock() const override { return wouldBlock; }
+
+		bool SetNonBlocking() override
+		{
+			nonBlocking = true;
+			return true;
+		}
+
+		socket_t Handle() const override { return INVALID_SOCKET; }
+
+		void Shutdown() override
+		{
+			for (LoopbackPipe* pipe : { in.get(), out.get() })
+			{
+				std::lock_guard<std::mutex> lock(pipe->mutex);
+				pipe->closed = true;
+				pipe->readable.notify_all();
+			}
+		}
+
+		void Close() override { Shutdown(); }
+
+	private:
+		std::shared_ptr<LoopbackPipe> in;
+		std::shared_ptr<LoopbackPipe> out;
+		bool nonBlocking = false;
+		bool wouldBlock = false;
+	};
+
+	// Connections waiting to be accepted on one loopback name
+	struct LoopbackEndpoint
+	{
+		std::mutex mutex;
+		std::deque<std::unique_ptr<Connection>> pending;
+	};
+
+	// Loopback names are process-wide, so any loopback transport can reach any listener
+	std::mutex loopbackMutex;
+	std::map<std::string, std::shared_ptr<LoopbackEndpoint>> loopbackEndpoints;
+
+	class LoopbackListener : public Listener
+	{
+	public:
+		LoopbackListener(const std::string& name, const std::shared_ptr<LoopbackEndpoint>& endpoint)
+			: name(name), endpoint(endpoint) {}
+		~LoopbackListener() override { Close(); }
+
+		std::unique_ptr<Connection> Accept() override
+		{
+			std::lock_guard<std::mutex> lock(endpoint->mutex);
+			if (endpoint->pending.empty())
+				return nullptr;
+			std::unique_ptr<Connection> connection = std::move(endpoint->pending.front());
+			endpoint->pending.pop_front();
+			return connection;
+		}
+
+		socket_t Handle() const override { return INVALID_SOCKET; }
+
+		void Close() override
+		{
+			std::lock_guard<std::mutex> lock(loopbackMutex);
+			auto it = loopbackEndpoints.find(name);
+			if (it != loopbackEndpoints.end() && it->second == endpoint)
+				loopbackEndpoints.erase(it);
+		}
+
+	private:
+		std::string name;
+		std::shared_ptr<LoopbackEndpoint> endpoint;
+	};
+
+	class LoopbackTransport : public Transport
+	{
+	public:
+		std::unique_ptr<Listener> Listen(const std::string& endpoint, int backlog) override
+		{
+			(void)backlog;
+			std::lock_guard<std::mutex> lock(loopbackMutex);
+			if (loopbackEndpoints.count(endpoint) != 0)
+			{
+				printf("Loopback endpoint '%s' is already in use\n", endpoint.c_str());
+				return nullptr;
+			}
+			std::shared_ptr<LoopbackEndpoint> state = std::make_shared<LoopbackEndpoint>();
+			loopbackEndpoints[endpoint] = state;
+			return std::unique_ptr<Listener>(new LoopbackListener(endpoint, state));
+		}
+
+		std::unique_ptr<Connection> Connect(const std::string& endpoint) override
+		{
+			std::shared_ptr<LoopbackEndpoint> state;
+			{
+				std::lock_guard<std::mutex> lock(loopbackMutex);
+				auto it = loopbackEndpoints.find(endpoint);
+				if (it == loopbackEndpoints.end())
+					return nullptr;
+				state = it->second;
+			}
+			std::shared_ptr<LoopbackPipe> toServer = std::make_shared<LoopbackPipe>();
+			std::shared_ptr<LoopbackPipe> toClient = std::make_shared<LoopbackPipe>();
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->pending.emplace_back(new LoopbackConnection(toServer, toClient));
+			return std::unique_ptr<Connection>(new LoopbackConnection(toClient, toServer));
+		}
+
+		const char* Name() const override { return "mem"; }
+	};
+}
+
+std::unique_ptr<Transport> CreateTcpTransport()
+{
+	return std::unique_ptr<Transport>(new TcpTransport());
+}
+
+std::unique_ptr<Transport> CreateUnixTransport()
+{
+#ifdef _WIN32
+	return nullptr;
+#else
+	return std::unique_ptr<Transport>(new UnixTransport());
+#endif
+}
+
+std::unique_ptr<Transport> CreateLoopbackTransport()
+{
+	return std::unique_ptr<Transport>(new LoopbackTransport());
+}
+
+std::unique_ptr<Connection> AdoptTcpSocket(socket_t sock)
+{
+	return std::unique_ptr<Connection>(new SocketConnection(sock, true));
+}
+
+std::unique_ptr<Transport> CreateTransportFor(const std::string& address, std::string& endpoint)
+{
+	if (address.compare(0, 5, "unix:") == 0)
+	{
+		endpoint = address.substr(5);
+		return CreateUnixTransport();
+	}
+	if (address.compare(0, 4, "mem:") == 0)
+	{
+		endpoint = address.substr(4);
+		return CreateLoopbackTransport();
+	}
+	endpoint = address;
+	return CreateTcpTransport();
+}
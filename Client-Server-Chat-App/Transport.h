@@ -0,0 +1,147 @@
+#pragma once
+/**
+ * @file Transport.h
+ * @brief Pluggable byte-stream transports used by the client and the relay engine.
+ *
+ * The chat code talks to Connection and Listener objects instead of calling
+ * Winsock or BSD sockets directly. Three backends exist:
+ *
+ * - TCP ("host:port"), on Winsock or POSIX sockets;
+ * - Unix domain sockets (a filesystem path), for clients on the same host (not on Windows);
+ * - in-memory loopback (any name), a pair of in-process pipes with no kernel
+ *   involvement, used to benchmark the relay engine on its own.
+ *
+ * Socket-backed connections expose their descriptor through Handle() so they
+ * can be multiplexed with select(); loopback connections return INVALID_SOCKET
+ * and are driven directly by their owner.
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "SocketCompat.h"
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief One bidirectional byte stream.
+ *
+ * Recv/Send/SendV return the number of bytes transferred, 0 from Recv on an
+ * orderly shutdown by the other side, or SOCKET_ERROR; after an error,
+ * WouldBlock() tells whether the call merely had to wait.
+ */
+class Connection
+{
+public:
+	virtual ~Connection() {}
+
+	virtual long Recv(char* buffer, size_t length) = 0;
+	virtual long Send(const char* data, size_t length) = 0;
+
+	/**
+	 * @brief Writes several buffers at once (see SocketSendV).
+	 */
+	virtual long SendV(const ConstBuffer* buffers, size_t count) = 0;
+
+	// True if the last failed call only had to wait
+	virtual bool WouldBlock() const = 0;
+
+	virtual bool SetNonBlocking() = 0;
+
+	// Latency/coalescing knobs; backends without them report false
+	virtual bool SetNoDelay(bool enabled) { (void)enabled; return false; }
+	virtual bool SetCork(bool enabled) { (void)enabled; return false; }
+
+	// Kernel buffer sizes in bytes (0 keeps the current size); backends without kernel buffers report false
+	virtual bool SetBufferSizes(int receiveBytes, int sendBytes) { (void)receiveBytes; (void)sendBytes; return false; }
+
+	// Descriptor usable with select(), or INVALID_SOCKET
+	virtual socket_t Handle() const = 0;
+
+	/**
+	 * @brief Stops both directions without releasing the connection, which wakes up a blocked reader.
+	 */
+	virtual void Shutdown() = 0;
+
+	virtual void Close() = 0;
+};
+
+/**
+ * @brief Accepts incoming connections on one endpoint.
+ */
+class Listener
+{
+public:
+	virtual ~Listener() {}
+
+	/**
+	 * @brief Returns the next pending connection, or nullptr if there is none.
+	 */
+	virtual std::unique_ptr<Connection> Accept() = 0;
+
+	/**
+	 * @brief Sets the kernel buffer sizes that accepted connections inherit (see Connection::SetBufferSizes).
+	 *
+	 * Setting them here rather than per connection lets TCP advertise a large
+	 * receive window from the handshake on.
+	 */
+	virtual bool SetBufferSizes(int receiveBytes, int sendBytes) { (void)receiveBytes; (void)sendBytes; return false; }
+
+	// Descriptor usable with select(), or INVALID_SOCKET
+	virtual socket_t Handle() const = 0;
+
+	virtual void Close() = 0;
+};
+
+/**
+ * @brief Factory for listeners and outgoing connections of one backend.
+ */
+class Transport
+{
+public:
+	virtual ~Transport() {}
+
+	/**
+	 * @brief Starts listening on an endpoint.
+	 * @return nullptr on failure; the reason has been printed.
+	 */
+	virtual std::unique_ptr<Listener> Listen(const std::string& endpoint, int backlog) = 0;
+
+	/**
+	 * @brief Connects to an endpoint (blocking).
+	 * @return nullptr on failure.
+	 */
+	virtual std::unique_ptr<Connection> Connect(const std::string& endpoint) = 0;
+
+	virtual const char* Name() const = 0;
+};
+
+/**
+ * @brief TCP over Winsock or POSIX sockets; endpoints are "host:port" (":port" listens on all interfaces).
+ *
+ * Winsock is started for as long as a TCP transport exists.
+ */
+std::unique_ptr<Transport> CreateTcpTransport();
+
+/**
+ * @brief Unix domain sockets; endpoints are filesystem paths.
+ * @return nullptr where Unix domain sockets are not supported.
+ */
+std::unique_ptr<Transport> CreateUnixTransport();
+
+/**
+ * @brief In-process pipes; endpoints are arbitrary names shared by Listen and Connect of the same transport.
+ */
+std::unique_ptr<Transport> CreateLoopbackTransport();
+
+/**
+ * @brief Wraps an already connected TCP socket; the connection closes it when destroyed.
+ */
+std::unique_ptr<Connection> AdoptTcpSocket(socket_t sock);
+
+/**
+ * @brief Picks the backend for an address: "unix:<path>" or "mem:<name>" select those backends, anything else is TCP.
+ * @param endpoint Receives the address without its scheme.
+ */
+std::unique_ptr<Transport> CreateTransportFor(const std::string& address, std::string& endpoint);
@@ -3,28 +3,140 @@
  * @brief Entry point for the chat application. Allows user to choose server or client mode.
  *
  * Prompts the user to select whether to run as a server or a client, then calls
- * the appropriate initialization function.
+ * the appropriate initialization function. Builds that define CHAT_APP_MODE
+ * (1 = server, 2 = client) skip the prompt; see CMakeLists.txt.
  *
+ * With command-line arguments nothing is asked: "server" reads its profile from
+ * --config and --<key> options (see ServerProfile.h), "client" takes --address,
+ * --port, --nick and its output batching (--batch-window-us, --batch-bytes).
+ * Run with --help for the list.
  *
  * @author Nikita Struk
  * @date May 30, 2025
- * Last updated: June 3, 2025
+ * Last updated: October 18, 2026
  */
+#include <stdio.h>
+#include <stdlib.h>
 #include <iostream>  
+#include <limits>
 #include <string>
+#include <vector>
 
+#include "Federation.h"
+#include "ServerProfile.h"
 
 
-void InitializeServer();  
+
+void InitializeServer(const ServerProfile& profile);  
 void InitializeClient(const std::string& serverAddress, 
 					  const unsigned int& serverPort, 
-					  mutable std::string userNickname);
+					  std::string userNickname,
+					  const BatchingOptions& batching = BatchingOptions());
+
+static void PrintUsage(const char* program)
+{
+	printf("Usage: %s server [--config <file>] [--<setting> <value>...]\n", program);
+	printf("       %s client [--address <host or unix:path>] [--port <port>] [--nick <nickname>]\n", program);
+	printf("              [--batch-window-us <0-1000000>] [--batch-bytes <bytes>]\n");
+	printf("The server and client builds accept their options without the mode word.\n");
+	printf("Without arguments the settings are asked for interactively.\n\n");
+	printf("Server settings:\n");
+	PrintServerSettingsHelp(stdout);
+}
+
+// Runs the mode and settings given on the command line
+static int RunFromArguments(int argc, char** argv)
+{
+	int choice = 0;
+#ifdef CHAT_APP_MODE
+	choice = CHAT_APP_MODE;
+#endif
+	int first = 1;
+	std::string mode = argv[1];
+	if (mode == "--help" || mode == "-h")
+	{
+		PrintUsage(argv[0]);
+		return 0;
+	}
+	if (mode == "server" || mode == "client")
+	{
+		choice = mode == "server" ? 1 : 2;
+		first = 2;
+	}
+
+	std::string error;
+	if (choice == 1)
+	{
+		ServerProfile profile;
+		if (!LoadServerProfile(argc, argv, first, profile, error))
+		{
+			printf("Invalid server settings: %s\nRun %s --help for the list.\n", error.c_str(), argv[0]);
+			return 1;
+		}
+		printf("Server profile:\n");
+		PrintServerProfile(profile, stdout);
+		InitializeServer(profile);
+		return 0;
+	}
+	if (choice == 2)
+	{
+		std::vector<Setting> settings;
+		std::string serverAddress = "127.0.0.1";
+		unsigned int serverPort = DEFAULT_SERVER_PORT;
+		std::string userNickname = "Anonymous";
+		BatchingOptions batching;
+		bool valid = ParseSettingArguments(argc, argv, first, settings, error);
+		for (size_t i = 0; valid && i < settings.size(); i++)
+		{
+			const Setting& setting = settings[i];
+			if (setting.first == "address")
+				serverAddress = setting.second;
+			else if (setting.first == "port")
+				serverPort = (unsigned int)atoi(setting.second.c_str());
+			else if (setting.first == "nick")
+				userNickname = setting.second;
+			else if (setting.first == "batch-window-us" || setting.first == "batch-bytes")
+			{
+				// Same meaning and limits as the server settings of the same name
+				ServerProfile scratch;
+				scratch.batching = batching;
+				if (ApplyServerSetting(scratch, setting.first, setting.second, error))
+					batching = scratch.batching;
+			}
+			else
+				error = "unknown setting '" + setting.first + "'";
+			valid = error.empty();
+		}
+		if (valid && (serverPort == 0 || serverPort > 65535))
+		{
+			error = "port: expected a number from 1 to 65535";
+			valid = false;
+		}
+		if (!valid)
+		{
+			printf("Invalid client settings: %s\nRun %s --help for the list.\n", error.c_str(), argv[0]);
+			return 1;
+		}
+		std::cout << "Starting in client mode..." << std::endl;
+		InitializeClient(serverAddress, serverPort, userNickname, batching);
+		return 0;
+	}
+	PrintUsage(argv[0]);
+	return 1;
+}
 
-int main()  
+int main(int argc, char** argv)  
 {  
 	int choice = 0;  
 	// Display welcome message and options  
 	std::cout << "Welcome to the Chat Application!" << std::endl;  
+	if (argc > 1)
+	{
+		return RunFromArguments(argc, argv);
+	}
+#ifdef CHAT_APP_MODE
+	choice = CHAT_APP_MODE;
+#else
 	std::cout << "1. Run as Server\n";  
 	std::cout << "2. Run as Client\n";  
 	std::cout << "Enter your choice (1 or 2): ";  
@@ -32,19 +144,66 @@ int main()
 
 	// Clear input buffer in case of leftover newline  
 	std::cin.ignore(10000, '\n');  
+#endif
 
 	if (choice == 1)  
 	{  
-		InitializeServer();  
+		// Interactive setup covers the endpoints; everything else keeps its default
+		ServerProfile profile;
+		std::cout << "Input the server port (0 for the default " << DEFAULT_SERVER_PORT << "): \n";
+		unsigned int serverPort = 0;
+		std::cin >> serverPort;
+		if (serverPort > 0 && serverPort <= 65535)
+		{
+			profile.port = (unsigned short)serverPort;
+		}
+#ifndef _WIN32
+		// Clients on this host may connect through a Unix domain socket instead of TCP
+		std::cout << "Input a Unix socket path for local clients (empty for none): \n";
+		std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+		std::getline(std::cin, profile.unixSocketPath);
+#endif
+		// Federation: link this server with other nodes so they act as one chat
+		FederationOptions& federationOptions = profile.federation;
+		std::cout << "Input the peer port for other server nodes (0 to run standalone): \n";
+		unsigned int peerPort = 0;
+		std::cin >> peerPort;
+		std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+		if (peerPort > 0 && peerPort <= 65535)
+		{
+			federationOptions.peerPort = (unsigned short)peerPort;
+			std::cout << "Input this node's name (empty for node-" << peerPort << "): ";
+			std::getline(std::cin, federationOptions.nodeId);
+			if (federationOptions.nodeId.empty())
+			{
+				federationOptions.nodeId = "node-" + std::to_string(peerPort);
+			}
+			std::cout << "Input the peer nodes to dial (host:port, comma-separated, empty for none): ";
+			std::string peerList;
+			std::getline(std::cin, peerList);
+			if (!ParsePeerList(peerList, federationOptions.peers))
+			{
+				std::cout << "Invalid peer list. Expected host:port[,host:port...]" << std::endl;
+				return 1;
+			}
+		}
+		InitializeServer(profile);  
 	}  
 	else if (choice == 2)  
 	{  
+#ifdef _WIN32
 		std::cout << "Input the server IP address: \n";
+#else
+		std::cout << "Input the server IP address (or unix:<path> for a Unix domain socket): \n";
+#endif
 		std::string serverAddress{};
 		std::cin >> serverAddress;
-		std::cout << "Input the server IP port: \n";
 		unsigned int serverPort = 0;
-		std::cin >> serverPort;
+		if (serverAddress.compare(0, 5, "unix:") != 0)
+		{
+			std::cout << "Input the server IP port: \n";
+			std::cin >> serverPort;
+		}
 		//Prompt for nickname
 		std::string userNickname;
 		std::cout << "Enter your nickname: ";
@@ -0,0 +1,263 @@
+/**
+ * @file AdminStressBench.cpp
+ * @brief Relay throughput while the admin console hammers the server.
+ *
+ * Runs the relay benchmark setup (one sender, several receivers, a RelayEngine
+ * driven by a select() loop over TCP on 127.0.0.1) twice:
+ *
+ * - quiet: no admin activity;
+ * - admin: another thread posts admin commands as fast as it can - /mute and
+ *   /unmute of two idle clients, /kick of a nickname nobody uses - and reads
+ *   the published user snapshot after each one, like /users and /who do.
+ *
+ * Every receiver must still get every line, so the run also checks that the
+ * admin traffic neither loses messages nor stalls the relay. At the end a
+ * /kickall is posted and must disconnect every client.
+ *
+ * Usage: AdminStressBench [receivers] [messages] [tcpPort]
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "AdminControl.h"
+#include "Federation.h"
+#include "Framing.h"
+#include "OutputBatcher.h"
+#include "RelayEngine.h"
+#include "Transport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bytes of chat text behind the nickname in every message
+#define MESSAGE_TEXT_SIZE 64
+
+// Clients that only sit there to be muted and unmuted
+#define IDLE_CLIENTS 2
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct RunResult
+	{
+		double deliveriesPerSecond = 0;
+		unsigned long long commands = 0;
+		unsigned long long snapshotReads = 0;
+		double seconds = 0;
+		bool complete = false;
+		bool kickedAll = false;
+	};
+
+	bool SendFrame(Connection& connection, const std::string& payload)
+	{
+		std::string frame;
+		AppendFrame(frame, payload.data(), payload.size());
+		const char* data = frame.data();
+		size_t length = frame.size();
+		while (length > 0)
+		{
+			long sent = connection.Send(data, length);
+			if (sent <= 0)
+				return false;
+			data += sent;
+			length -= (size_t)sent;
+		}
+		return true;
+	}
+
+	// Counts chat lines until expected arrived (expected < 0: until the connection closes)
+	void ReceiveLoop(Connection* connection, int expected, std::atomic<int>* complete)
+	{
+		FrameReader reader;
+		std::string payload;
+		char chunk[65536];
+		int received = 0;
+		while (expected < 0 || received < expected)
+		{
+			long valueRead = connection->Recv(chunk, sizeof(chunk));
+			if (valueRead <= 0)
+				return;
+			reader.Feed(chunk, (size_t)valueRead);
+			while (reader.Next(payload))
+			{
+				if (payload.compare(0, 8, "sender: ") == 0)
+					received++;
+			}
+		}
+		(*complete)++;
+	}
+
+	// The server loop: select() over the clients and the admin wake-up descriptor
+	void ServerLoop(RelayEngine& engine, OutputBatcher& batcher, AdminQueue& admin,
+					const std::atomic<bool>& stop, std::atomic<unsigned long long>* commands)
+	{
+		while (!stop)
+		{
+			fd_set readfds;
+			FD_ZERO(&readfds);
+			int maxSD = 0;
+			if (admin.WakeHandle() != INVALID_SOCKET)
+			{
+				FD_SET(admin.WakeHandle(), &readfds);
+				maxSD = (int)admin.WakeHandle();
+			}
+			engine.AddToReadSet(readfds, maxSD);
+			struct timeval timeout = { 0, ADMIN_POLL_MS * 1000 };
+			int activity = select(maxSD + 1, &readfds, NULL, NULL, &timeout);
+			if (activity > 0 && admin.WakeHandle() != INVALID_SOCKET && FD_ISSET(admin.WakeHandle(), &readfds))
+				admin.ClearWake();
+			*commands += engine.ProcessAdmin(admin);
+			if (activity > 0)
+				engine.ProcessReadSet(readfds);
+			batcher.FlushDue();
+			engine.RefreshUsers();
+		}
+	}
+
+	RunResult Run(Transport& transport, const std::string& endpoint, int receivers, int messages, bool stress)
+	{
+		RunResult result;
+		std::unique_ptr<Listener> listener = transport.Listen(endpoint, DEFAULT_MAX_CLIENTS);
+		if (!listener)
+			return result;
+
+		FederationOptions federationOptions;
+		FederationBus federation(federationOptions);
+		OutputBatcher batcher;
+		RelayOptions relayOptions;
+		relayOptions.logMessages = false;
+		relayOptions.echoMessages = false;
+		relayOptions.echoEvents = false;
+		RelayEngine engine(federation, batcher, relayOptions);
+		AdminQueue admin;
+
+		// Client 0 sends, the receivers follow, the idle clients come last
+		std::vector<std::unique_ptr<Connection>> clients;
+		for (int i = 0; i < 1 + receivers + IDLE_CLIENTS; i++)
+		{
+			std::unique_ptr<Connection> client = transport.Connect(endpoint);
+			std::unique_ptr<Connection> accepted = client ? listener->Accept() : nullptr;
+			if (!accepted)
+				return result;
+			accepted->SetNonBlocking();
+			engine.AddClient(std::move(accepted));
+			clients.push_back(std::move(client));
+		}
+		listener->Close();
+
+		std::atomic<bool> stop(false);
+		std::atomic<unsigned long long> commands(0);
+		std::thread server(ServerLoop, std::ref(engine), std::ref(batcher), std::ref(admin), std::cref(stop), &commands);
+
+		for (int i = 0; i < IDLE_CLIENTS; i++)
+			SendFrame(*clients[1 + receivers + i], "/hello idle-" + std::to_string(i));
+		SendFrame(*clients[0], "/hello sender");
+
+		std::atomic<int> complete(0);
+		std::vector<std::thread> readers;
+		for (int i = 1; i <= receivers; i++)
+			readers.emplace_back(ReceiveLoop, clients[i].get(), messages, &complete);
+		// Idle clients are drained too, so their socket buffers never fill up
+		std::atomic<int> idleDone(0);
+		for (int i = 0; i < IDLE_CLIENTS; i++)
+			readers.emplace_back(ReceiveLoop, clients[1 + receivers + i].get(), -1, &idleDone);
+
+		std::atomic<bool> relaying(true);
+		std::atomic<unsigned long long> snapshotReads(0);
+		std::thread adminThread;
+		if (stress)
+		{
+			adminThread = std::thread([&admin, &engine, &relaying, &snapshotReads]()
+			{
+				AdminCommand command;
+				unsigned long long round = 0;
+				while (relaying)
+				{
+					command.type = (round % 3 == 0) ? AdminCommand::Mute :
+								   (round % 3 == 1) ? AdminCommand::Unmute : AdminCommand::Kick;
+					command.nickname = command.type == AdminCommand::Kick ?
+									   "nobody" : "idle-" + std::to_string((round / 3) % IDLE_CLIENTS);
+					admin.Post(command);
+					if (engine.Users()->users.size() > 0)
+						snapshotReads++;
+					round++;
+				}
+			});
+		}
+
+		std::string line = "sender: " + std::string(MESSAGE_TEXT_SIZE, 'm');
+		auto start = Clock::now();
+		for (int i = 0; i < messages; i++)
+		{
+			if (!SendFrame(*clients[0], line))
+				break;
+		}
+		for (int i = 0; i < receivers; i++)
+			readers[i].join();
+		result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		relaying = false;
+		if (adminThread.joinable())
+			adminThread.join();
+		result.complete = complete == receivers;
+		result.deliveriesPerSecond = (double)messages * receivers / result.seconds;
+		result.snapshotReads = snapshotReads;
+
+		// Every client must be gone once /kickall ran
+		AdminCommand kickAll;
+		kickAll.type = AdminCommand::KickAll;
+		admin.Post(kickAll);
+		auto deadline = Clock::now() + std::chrono::seconds(5);
+		while (engine.ClientCount() > 0 && Clock::now() < deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		result.kickedAll = engine.ClientCount() == 0;
+		result.commands = commands;
+
+		stop = true;
+		server.join();
+		for (const auto& client : clients)
+			client->Shutdown();
+		for (size_t i = receivers; i < readers.size(); i++)
+			readers[i].join();
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int receivers = argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_CLIENTS - 1 - IDLE_CLIENTS;
+	int messages = argc > 2 ? atoi(argv[2]) : 100000;
+	int tcpPort = argc > 3 ? atoi(argv[3]) : 18090;
+	if (receivers < 1 || receivers > DEFAULT_MAX_CLIENTS - 1 - IDLE_CLIENTS || messages < 1 || tcpPort < 1 || tcpPort > 65535)
+	{
+		fprintf(stderr, "Usage: %s [receivers 1-%d] [messages] [tcpPort]\n", argv[0], DEFAULT_MAX_CLIENTS - 1 - IDLE_CLIENTS);
+		return 1;
+	}
+
+	// Also starts Winsock for the whole run
+	std::unique_ptr<Transport> tcp = CreateTcpTransport();
+	std::string endpoint = "127.0.0.1:" + std::to_string(tcpPort);
+
+	printf("receivers=%d messages=%d\n", receivers, messages);
+	printf("%-8s %-14s %-12s %-14s %-16s %-10s %-8s\n",
+		   "run", "deliveries/s", "commands", "commands/s", "snapshot reads", "complete", "kickall");
+	int failures = 0;
+	for (bool stress : { false, true })
+	{
+		RunResult result = Run(*tcp, endpoint, receivers, messages, stress);
+		printf("%-8s %-14.0f %-12llu %-14.0f %-16llu %-10s %-8s\n", stress ? "admin" : "quiet",
+			   result.deliveriesPerSecond, result.commands, result.commands / result.seconds, result.snapshotReads,
+			   result.complete ? "yes" : "NO", result.kickedAll ? "yes" : "NO");
+		fflush(stdout);
+		if (!result.complete || !result.kickedAll)
+			failures++;
+	}
+	return failures == 0 ? 0 : 1;
+}
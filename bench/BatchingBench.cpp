@@ -0,0 +1,270 @@
+/**
+ * @file BatchingBench.cpp
+ * @brief Latency vs. throughput of the output batching layer across batching windows.
+ *
+ * Plays the server side of a broadcast: one sender thread relays every message
+ * to a number of loopback client connections through an OutputBatcher, and one
+ * thread per client decodes the frames and measures how long each message took
+ * to arrive. Every batching window is run twice:
+ *
+ * - flat out, to measure delivered messages per second and writes per frame;
+ * - paced at a fixed message rate, to measure delivery latency (p50 / p99).
+ *
+ * The "send" row is the old behaviour for reference: one send() per message per
+ * recipient, no batching, Nagle left on.
+ *
+ * Usage: BatchingBench [recipients] [messages] [pacedRate] [window_us...]
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Framing.h"
+#include "OutputBatcher.h"
+#include "Transport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bytes of chat text behind the timestamp in every message
+#define MESSAGE_TEXT_SIZE 64
+
+// Marks the unbatched reference run in the list of windows
+#define UNBATCHED_WINDOW -1
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	long long NowNanos()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+	}
+
+	struct RunResult
+	{
+		double messagesPerSecond = 0;
+		double writesPerMessage = 0;
+		double p50Micros = 0;
+		double p99Micros = 0;
+	};
+
+	// Loopback client connections and the server-side sockets they were accepted on
+	struct Fixture
+	{
+		std::vector<socket_t> clients;
+		std::vector<std::unique_ptr<Connection>> accepted;
+
+		bool Open(int recipients)
+		{
+			socket_t listener = socket(AF_INET, SOCK_STREAM, 0);
+			struct sockaddr_in address;
+			memset(&address, 0, sizeof(address));
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			address.sin_port = 0;
+			socklen_t length = sizeof(address);
+			if (listener == INVALID_SOCKET ||
+				bind(listener, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+				listen(listener, SOMAXCONN) == SOCKET_ERROR ||
+				getsockname(listener, (struct sockaddr*)&address, &length) == SOCKET_ERROR)
+				return false;
+
+			for (int i = 0; i < recipients; i++)
+			{
+				socket_t client = socket(AF_INET, SOCK_STREAM, 0);
+				if (connect(client, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR)
+					return false;
+				clients.push_back(client);
+				accepted.push_back(AdoptTcpSocket(accept(listener, nullptr, nullptr)));
+			}
+			closesocket(listener);
+			return true;
+		}
+
+		void Close()
+		{
+			for (socket_t s : clients)
+				closesocket(s);
+			clients.clear();
+			accepted.clear();
+		}
+	};
+
+	// Reads frames until expected messages arrived, collecting their delivery latency
+	void ReceiveLoop(socket_t sock, int expected, std::vector<long long>* latencies)
+	{
+		FrameReader reader;
+		std::string payload;
+		char chunk[65536];
+		int received = 0;
+		while (received < expected)
+		{
+			int valueRead = recv(sock, chunk, sizeof(chunk), 0);
+			if (valueRead <= 0)
+				return;
+			reader.Feed(chunk, (size_t)valueRead);
+			long long now = NowNanos();
+			while (reader.Next(payload))
+			{
+				long long sentAt = 0;
+				memcpy(&sentAt, payload.data(), sizeof(sentAt));
+				if (latencies != nullptr)
+					latencies->push_back(now - sentAt);
+				received++;
+			}
+		}
+	}
+
+	std::string MakeMessage(const std::string& text)
+	{
+		long long sentAt = NowNanos();
+		std::string message((const char*)&sentAt, sizeof(sentAt));
+		message += text;
+		return message;
+	}
+
+	RunResult Run(int window, int recipients, int messages, int pacedRate, bool paced)
+	{
+		RunResult result;
+		Fixture fixture;
+		if (!fixture.Open(recipients))
+		{
+			fprintf(stderr, "Could not open loopback connections\n");
+			exit(EXIT_FAILURE);
+		}
+
+		BatchingOptions options;
+		options.windowMicros = window > 0 ? (unsigned int)window : 0;
+		OutputBatcher batcher(options);
+		for (const auto& connection : fixture.accepted)
+		{
+			if (window != UNBATCHED_WINDOW)
+				batcher.Attach(connection.get());
+		}
+
+		std::vector<std::vector<long long>> latencies(recipients);
+		std::vector<std::thread> receivers;
+		for (int i = 0; i < recipients; i++)
+			receivers.emplace_back(ReceiveLoop, fixture.clients[i], messages, paced ? &latencies[i] : nullptr);
+
+		std::string text(MESSAGE_TEXT_SIZE, 'm');
+		unsigned long long unbatchedWrites = 0;
+		auto interval = std::chrono::nanoseconds(paced ? 1000000000LL / pacedRate : 0);
+		auto start = Clock::now();
+		auto nextSend = start;
+		for (int i = 0; i < messages; i++)
+		{
+			if (paced)
+			{
+				// Keep due batches moving while waiting for the next message to be "typed"
+				while (Clock::now() < nextSend)
+				{
+					batcher.FlushDue();
+					std::this_thread::yield();
+				}
+				nextSend += interval;
+			}
+
+			std::string message = MakeMessage(text);
+			if (window == UNBATCHED_WINDOW)
+			{
+				std::string frame;
+				AppendFrame(frame, message.data(), message.size());
+				for (const auto& connection : fixture.accepted)
+				{
+					connection->Send(frame.data(), frame.size());
+					unbatchedWrites++;
+				}
+				continue;
+			}
+			std::shared_ptr<const std::string> frame = OutputBatcher::MakeFrame(message.data(), message.size());
+			for (const auto& connection : fixture.accepted)
+				batcher.Queue(connection.get(), frame);
+			batcher.FlushDue();
+		}
+		batcher.FlushAll();
+
+		for (std::thread& receiver : receivers)
+			receiver.join();
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		for (const auto& connection : fixture.accepted)
+			batcher.Detach(connection.get());
+		fixture.Close();
+
+		unsigned long long deliveries = (unsigned long long)messages * recipients;
+		unsigned long long writes = window == UNBATCHED_WINDOW ? unbatchedWrites : batcher.Stats().writes;
+		result.messagesPerSecond = deliveries / seconds;
+		result.writesPerMessage = (double)writes / deliveries;
+
+		if (paced)
+		{
+			std::vector<long long> all;
+			for (const auto& samples : latencies)
+				all.insert(all.end(), samples.begin(), samples.end());
+			std::sort(all.begin(), all.end());
+			if (!all.empty())
+			{
+				result.p50Micros = all[all.size() / 2] / 1000.0;
+				result.p99Micros = all[std::min(all.size() - 1, all.size() * 99 / 100)] / 1000.0;
+			}
+		}
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int recipients = argc > 1 ? atoi(argv[1]) : 10;
+	int messages = argc > 2 ? atoi(argv[2]) : 100000;
+	int pacedRate = argc > 3 ? atoi(argv[3]) : 20000;
+	if (recipients < 1 || messages < 1 || pacedRate < 1)
+	{
+		fprintf(stderr, "Usage: %s [recipients] [messages] [pacedRate] [window_us...]\n", argv[0]);
+		return 1;
+	}
+	std::vector<int> windows;
+	for (int i = 4; i < argc; i++)
+		windows.push_back(atoi(argv[i]));
+	if (windows.empty())
+		windows = { UNBATCHED_WINDOW, 0, 50, 100, 250, 500, 1000, 2000 };
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		fprintf(stderr, "WSAStartup failed\n");
+		return 1;
+	}
+#endif
+
+	printf("recipients=%d messages=%d paced rate=%d msg/s\n", recipients, messages, pacedRate);
+	printf("%-10s %-16s %-14s %-12s %-12s\n", "window_us", "deliveries/s", "writes/msg", "p50_us", "p99_us");
+	for (int window : windows)
+	{
+		RunResult flatOut = Run(window, recipients, messages, pacedRate, false);
+		// The paced run sends for a couple of seconds at most
+		int pacedMessages = std::min(messages, pacedRate * 2);
+		RunResult paced = Run(window, recipients, pacedMessages, pacedRate, true);
+		char label[16];
+		if (window == UNBATCHED_WINDOW)
+			snprintf(label, sizeof(label), "send");
+		else
+			snprintf(label, sizeof(label), "%d", window);
+		printf("%-10s %-16.0f %-14.3f %-12.1f %-12.1f\n",
+			   label, flatOut.messagesPerSecond, flatOut.writesPerMessage, paced.p50Micros, paced.p99Micros);
+		fflush(stdout);
+	}
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file FederationBench.cpp
+ * @brief Aggregate relay throughput of a federated cluster as nodes are added.
+ *
+ * For every cluster size from 1 to maxNodes, starts that many federation nodes
+ * in this process, links them in a full mesh over loopback and lets every node
+ * publish the same number of chat lines as fast as it can. Each node runs its
+ * own select() loop on its own thread, exactly like a server would. The run ends
+ * when every node has received every line published by the others.
+ *
+ * Usage: FederationBench [maxNodes] [messagesPerNode] [basePort]
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Federation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Chat lines queued per node on every pass of its loop
+#define PUBLISH_BATCH 256
+
+// Give up on a cluster size after this long
+#define RUN_TIMEOUT_SECONDS 60
+
+namespace
+{
+	struct ClusterResult
+	{
+		double seconds = 0;
+		unsigned long long deliveries = 0;
+		bool timedOut = false;
+	};
+
+	ClusterResult RunCluster(int nodes, int messagesPerNode, int basePort)
+	{
+		std::vector<std::unique_ptr<FederationBus>> buses;
+		for (int i = 0; i < nodes; i++)
+		{
+			FederationOptions options;
+			options.nodeId = "bench-" + std::to_string(i);
+			options.peerPort = (unsigned short)(basePort + i);
+			// Every node dials the ones started before it, which gives a full mesh
+			for (int j = 0; j < i; j++)
+			{
+				PeerAddress peer;
+				peer.host = "127.0.0.1";
+				peer.port = (unsigned short)(basePort + j);
+				options.peers.push_back(peer);
+			}
+			buses.emplace_back(new FederationBus(options));
+			if (!buses.back()->Start())
+			{
+				fprintf(stderr, "Could not start node %d on port %d\n", i, basePort + i);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		std::atomic<int> linked(0);
+		std::atomic<int> finished(0);
+		std::atomic<bool> go(false);
+		std::atomic<bool> abort(false);
+		std::atomic<unsigned long long> deliveries(0);
+		std::string padding(48, 'x');
+
+		auto nodeLoop = [&](int index)
+		{
+			FederationBus& bus = *buses[index];
+			std::vector<FederationEvent> events;
+			const unsigned long long expected = (unsigned long long)(nodes - 1) * messagesPerNode;
+			unsigned long long received = 0;
+			int published = 0;
+			bool reportedLinked = false;
+			bool reportedFinished = false;
+
+			while (finished.load() < nodes && !abort.load())
+			{
+				fd_set readfds, writefds;
+				FD_ZERO(&readfds);
+				FD_ZERO(&writefds);
+				int maxSD = 0;
+				bus.PrepareSelect(readfds, writefds, maxSD);
+				struct timeval tick = { 0, 1000 };
+				if (select(maxSD + 1, &readfds, &writefds, NULL, &tick) == SOCKET_ERROR)
+					break;
+
+				events.clear();
+				bus.ProcessSelect(readfds, writefds, events);
+				for (const FederationEvent& event : events)
+				{
+					if (event.type == FederationEvent::RemoteChat)
+						received++;
+				}
+
+				if (!reportedLinked && bus.LinkCount() == (size_t)(nodes - 1))
+				{
+					reportedLinked = true;
+					linked++;
+				}
+				if (go.load())
+				{
+					for (int n = 0; n < PUBLISH_BATCH && published < messagesPerNode; n++, published++)
+					{
+						std::string line = "user" + std::to_string(index) + ": message " +
+										   std::to_string(published) + " " + padding;
+						bus.PublishChat(line.data(), line.size());
+					}
+				}
+				bus.Flush();
+
+				if (!reportedFinished && published == messagesPerNode && received == expected)
+				{
+					reportedFinished = true;
+					deliveries += received;
+					finished++;
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 0; i < nodes; i++)
+			threads.emplace_back(nodeLoop, i);
+
+		ClusterResult result;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(RUN_TIMEOUT_SECONDS);
+		while (linked.load() < nodes && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+		auto start = std::chrono::steady_clock::now();
+		go = true;
+		while (finished.load() < nodes && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		auto end = std::chrono::steady_clock::now();
+
+		result.timedOut = finished.load() < nodes;
+		abort = true;
+		for (std::thread& thread : threads)
+			thread.join();
+
+		result.seconds = std::chrono::duration<double>(end - start).count();
+		result.deliveries = deliveries.load();
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int maxNodes = argc > 1 ? atoi(argv[1]) : 4;
+	int messagesPerNode = argc > 2 ? atoi(argv[2]) : 50000;
+	int basePort = argc > 3 ? atoi(argv[3]) : 19100;
+	if (maxNodes < 1 || messagesPerNode < 1 || basePort < 1 || basePort + maxNodes * (maxNodes + 1) > 65535)
+	{
+		fprintf(stderr, "Usage: %s [maxNodes] [messagesPerNode] [basePort]\n", argv[0]);
+		return 1;
+	}
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		fprintf(stderr, "WSAStartup failed\n");
+		return 1;
+	}
+#endif
+
+	printf("%-6s %-12s %-12s %-10s %-16s %-16s\n",
+		   "nodes", "published", "deliveries", "seconds", "published/s", "deliveries/s");
+	for (int nodes = 1; nodes <= maxNodes; nodes++)
+	{
+		// Fresh ports per cluster size so lingering sockets of the previous run never collide
+		int ports = basePort + (nodes - 1) * maxNodes;
+		ClusterResult result = RunCluster(nodes, messagesPerNode, ports);
+		unsigned long long published = (unsigned long long)nodes * messagesPerNode;
+		double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+		printf("%-6d %-12llu %-12llu %-10.3f %-16.0f %-16.0f%s\n",
+			   nodes, published, result.deliveries, result.seconds,
+			   published / seconds, result.deliveries / seconds,
+			   result.timedOut ? "  (timed out)" : "");
+		fflush(stdout);
+	}
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file OfflineQueueBench.cpp
+ * @brief Enqueue throughput and drain latency of the disk-backed offline queue.
+ *
+ * Queues a number of chat lines for offline recipients, then measures:
+ *
+ * - enqueue: lines appended per second (including the write to the log);
+ * - replay:  time to reopen the store and rebuild the queues from the segments;
+ * - drain:   time from Drain() until a client received the whole backlog, which
+ *            is handed over in one burst through an OutputBatcher on an
+ *            in-memory loopback connection;
+ * - bounded: the same enqueue against the default per-user budget, showing how
+ *            many lines are kept and dropped.
+ *
+ * Usage: OfflineQueueBench [messages] [recipients] [directory]
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Framing.h"
+#include "OfflineQueue.h"
+#include "OutputBatcher.h"
+#include "Transport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bytes of chat text behind the nickname in every message
+#define MESSAGE_TEXT_SIZE 64
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double SecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	std::string Nickname(int recipient)
+	{
+		return "user-" + std::to_string(recipient);
+	}
+
+	// Appends messages lines for every tracked recipient and returns the elapsed seconds
+	double Fill(OfflineStore& store, int messages)
+	{
+		std::string line = "sender: " + std::string(MESSAGE_TEXT_SIZE, 'm');
+		auto start = Clock::now();
+		for (int i = 0; i < messages; i++)
+			store.EnqueueForAll(line.data(), line.size());
+		store.Sync();
+		return SecondsSince(start);
+	}
+
+	// Counts frames until expected lines arrived
+	void ReceiveLoop(Connection* connection, size_t expected)
+	{
+		FrameReader reader;
+		std::string payload;
+		char chunk[65536];
+		size_t received = 0;
+		while (received < expected)
+		{
+			long valueRead = connection->Recv(chunk, sizeof(chunk));
+			if (valueRead <= 0)
+				return;
+			reader.Feed(chunk, (size_t)valueRead);
+			while (reader.Next(payload))
+				received++;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int messages = argc > 1 ? atoi(argv[1]) : 100000;
+	int recipients = argc > 2 ? atoi(argv[2]) : 1;
+	std::string directory = argc > 3 ? argv[3] : "offline-bench";
+	if (messages < 1 || recipients < 1)
+	{
+		fprintf(stderr, "Usage: %s [messages] [recipients] [directory]\n", argv[0]);
+		return 1;
+	}
+
+	OfflineOptions options;
+	options.directory = directory;
+	// Large enough to keep every line, so the drain really moves all of them
+	options.maxBytesPerUser = (size_t)messages * (FRAME_HEADER_SIZE + MESSAGE_TEXT_SIZE + 16);
+	options.maxRecipients = (size_t)recipients;
+
+	printf("messages=%d recipients=%d directory=%s\n", messages, recipients, directory.c_str());
+	{
+		OfflineStore store(options);
+		if (!store.Open())
+			return 1;
+		// Start from an empty log even if an earlier run was interrupted
+		store.RemoveFiles();
+		if (!store.Open())
+			return 1;
+		for (int r = 0; r < recipients; r++)
+			store.Track(Nickname(r));
+		double seconds = Fill(store, messages);
+		unsigned long long lines = (unsigned long long)messages * recipients;
+		printf("enqueue: %llu lines in %.3f s, %.0f lines/s\n", lines, seconds, lines / seconds);
+	}
+
+	OfflineStore store(options);
+	auto replayStart = Clock::now();
+	if (!store.Open())
+		return 1;
+	printf("replay:  %zu recipients, %zu lines pending for %s, %.3f s\n",
+		   store.RecipientCount(), store.PendingCount(Nickname(0)), Nickname(0).c_str(), SecondsSince(replayStart));
+
+	std::unique_ptr<Transport> loopback = CreateLoopbackTransport();
+	std::unique_ptr<Listener> listener = loopback->Listen("offline-bench", 1);
+	OutputBatcher batcher;
+	for (int r = 0; r < recipients; r++)
+	{
+		std::unique_ptr<Connection> client = loopback->Connect("offline-bench");
+		std::unique_ptr<Connection> server = listener->Accept();
+		batcher.Attach(server.get());
+		size_t expected = store.PendingCount(Nickname(r));
+
+		auto start = Clock::now();
+		std::thread receiver(ReceiveLoop, client.get(), expected);
+		std::string frames;
+		size_t count = store.Drain(Nickname(r), frames);
+		double drainSeconds = SecondsSince(start);
+		batcher.Queue(server.get(), std::make_shared<const std::string>(std::move(frames)));
+		batcher.Flush(server.get());
+		receiver.join();
+		double deliverSeconds = SecondsSince(start);
+		batcher.Detach(server.get());
+		if (r == 0 || r == recipients - 1)
+			printf("drain:   %s %zu lines, read %.2f ms, received %.2f ms\n",
+				   Nickname(r).c_str(), count, drainSeconds * 1000, deliverSeconds * 1000);
+	}
+	printf("compactions after drain: %llu\n", store.Stats().compactions);
+	store.RemoveFiles();
+
+	// Default per-user budget: the oldest lines make room for new ones
+	OfflineOptions bounded;
+	bounded.directory = directory;
+	OfflineStore boundedStore(bounded);
+	if (!boundedStore.Open())
+		return 1;
+	boundedStore.Track(Nickname(0));
+	double seconds = Fill(boundedStore, messages);
+	printf("bounded: budget %zu bytes, %zu lines kept, %llu dropped, %llu compactions, %.0f lines/s\n",
+		   bounded.maxBytesPerUser, boundedStore.PendingCount(Nickname(0)), boundedStore.Stats().dropped,
+		   boundedStore.Stats().compactions, messages / seconds);
+	boundedStore.RemoveFiles();
+	remove(directory.c_str());
+	return 0;
+}
@@ -0,0 +1,232 @@
+/**
+ * @file ProfileBench.cpp
+ * @brief Load generator for a running chat server, used to compare server profiles.
+ *
+ * Unlike the other benchmarks, which drive a RelayEngine in-process, this one
+ * connects to a real chat_server over TCP, so every setting of its profile
+ * (socket buffers, TCP_NODELAY, batching, read buffer, CPU affinity, logging)
+ * is part of the measurement. One sender and several receivers connect, then:
+ *
+ * - throughput: the sender writes messages lines as fast as it can, and the
+ *   rate is the number of lines delivered to all receivers per second;
+ * - latency: the sender writes paced lines carrying their send time, and the
+ *   receivers record how long each took to arrive (p50 / p99 / max).
+ *
+ * The last line of the output holds the results only, separated by spaces,
+ * for bench/profile_sweep.sh to record.
+ *
+ * Usage: ProfileBench <host:port> [receivers] [messages] [pacedRate]
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Framing.h"
+#include "Transport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bytes of chat text behind the nickname in every throughput line
+#define MESSAGE_TEXT_SIZE 64
+
+// Paced lines sent for the latency measurement
+#define LATENCY_MESSAGES 2000
+
+// Longest the whole run may take before it is reported as incomplete, in seconds
+#define RUN_TIMEOUT_SECONDS 60
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	long long NowNanos()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+	}
+
+	bool SendFrame(Connection& connection, const std::string& payload)
+	{
+		std::string frame;
+		AppendFrame(frame, payload.data(), payload.size());
+		const char* data = frame.data();
+		size_t length = frame.size();
+		while (length > 0)
+		{
+			long sent = connection.Send(data, length);
+			if (sent <= 0)
+				return false;
+			data += sent;
+			length -= (size_t)sent;
+		}
+		return true;
+	}
+
+	struct Receiver
+	{
+		std::unique_ptr<Connection> connection;
+		std::vector<double> latencies; // Microseconds, one per paced line
+		int throughputLines = 0;
+	};
+
+	struct Progress
+	{
+		std::atomic<int> ready{ 0 };           // Receivers the server has accepted
+		std::atomic<int> throughputDone{ 0 };  // Receivers that got every throughput line
+		std::atomic<int> latencyDone{ 0 };     // Receivers that got every paced line
+	};
+
+	void ReceiveLoop(Receiver* receiver, int messages, Progress* progress)
+	{
+		FrameReader reader;
+		std::string payload;
+		char chunk[65536];
+		bool ready = false;
+		while ((int)receiver->latencies.size() < LATENCY_MESSAGES)
+		{
+			long valueRead = receiver->connection->Recv(chunk, sizeof(chunk));
+			if (valueRead <= 0)
+				return;
+			reader.Feed(chunk, (size_t)valueRead);
+			while (reader.Next(payload))
+			{
+				// The answer to /users proves the server accepted this connection
+				if (!ready && payload.compare(0, 16, "Connected users:") == 0)
+				{
+					ready = true;
+					progress->ready++;
+				}
+				else if (payload.compare(0, 9, "sender: m") == 0 && ++receiver->throughputLines == messages)
+				{
+					progress->throughputDone++;
+				}
+				else if (payload.compare(0, 10, "sender: t ") == 0)
+				{
+					long long sentAt = atoll(payload.c_str() + 10);
+					receiver->latencies.push_back((NowNanos() - sentAt) / 1000.0);
+				}
+			}
+		}
+		progress->latencyDone++;
+	}
+
+	// Waits until counter reaches target or the deadline passes
+	bool WaitFor(const std::atomic<int>& counter, int target, Clock::time_point deadline)
+	{
+		while (counter < target)
+		{
+			if (Clock::now() > deadline)
+				return false;
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		return true;
+	}
+
+	// The server may still be starting; give it a few seconds
+	std::unique_ptr<Connection> ConnectWithRetry(Transport& transport, const std::string& endpoint)
+	{
+		for (int attempt = 0; attempt < 50; attempt++)
+		{
+			std::unique_ptr<Connection> connection = transport.Connect(endpoint);
+			if (connection)
+				return connection;
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+		return nullptr;
+	}
+
+	double Percentile(const std::vector<double>& sorted, double fraction)
+	{
+		if (sorted.empty())
+			return 0;
+		size_t index = (size_t)(fraction * (sorted.size() - 1));
+		return sorted[index];
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string endpoint = argc > 1 ? argv[1] : "";
+	int receivers = argc > 2 ? atoi(argv[2]) : 8;
+	int messages = argc > 3 ? atoi(argv[3]) : 100000;
+	int pacedRate = argc > 4 ? atoi(argv[4]) : 5000;
+	if (endpoint.empty() || receivers < 1 || messages < 1 || pacedRate < 1)
+	{
+		fprintf(stderr, "Usage: %s <host:port> [receivers] [messages] [pacedRate]\n", argv[0]);
+		return 1;
+	}
+
+	// Also starts Winsock for the whole run
+	std::unique_ptr<Transport> tcp = CreateTcpTransport();
+	std::unique_ptr<Connection> sender = ConnectWithRetry(*tcp, endpoint);
+	if (!sender)
+	{
+		fprintf(stderr, "Cannot connect to %s\n", endpoint.c_str());
+		return 1;
+	}
+	std::vector<Receiver> receiverList(receivers);
+	for (Receiver& receiver : receiverList)
+	{
+		receiver.connection = ConnectWithRetry(*tcp, endpoint);
+		if (!receiver.connection)
+		{
+			fprintf(stderr, "Cannot connect to %s\n", endpoint.c_str());
+			return 1;
+		}
+	}
+
+	Progress progress;
+	std::vector<std::thread> threads;
+	for (Receiver& receiver : receiverList)
+	{
+		threads.emplace_back(ReceiveLoop, &receiver, messages, &progress);
+		SendFrame(*receiver.connection, "/users");
+	}
+	Clock::time_point deadline = Clock::now() + std::chrono::seconds(RUN_TIMEOUT_SECONDS);
+	bool complete = WaitFor(progress.ready, receivers, deadline);
+
+	// Throughput: as fast as the server takes them
+	std::string line = "sender: m" + std::string(MESSAGE_TEXT_SIZE - 1, 'm');
+	auto start = Clock::now();
+	for (int i = 0; complete && i < messages; i++)
+		complete = SendFrame(*sender, line);
+	complete = complete && WaitFor(progress.throughputDone, receivers, deadline);
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	// Latency: paced, so queues stay short and the time is spent in the server and the kernel
+	auto interval = std::chrono::nanoseconds(1000000000LL / pacedRate);
+	auto next = Clock::now();
+	for (int i = 0; complete && i < LATENCY_MESSAGES; i++)
+	{
+		std::this_thread::sleep_until(next);
+		next += interval;
+		complete = SendFrame(*sender, "sender: t " + std::to_string(NowNanos()));
+	}
+	complete = complete && WaitFor(progress.latencyDone, receivers, deadline);
+
+	sender->Shutdown();
+	for (Receiver& receiver : receiverList)
+		receiver.connection->Shutdown();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	std::vector<double> latencies;
+	for (const Receiver& receiver : receiverList)
+		latencies.insert(latencies.end(), receiver.latencies.begin(), receiver.latencies.end());
+	std::sort(latencies.begin(), latencies.end());
+
+	printf("endpoint=%s receivers=%d messages=%d pacedRate=%d\n", endpoint.c_str(), receivers, messages, pacedRate);
+	printf("%-14s %-10s %-10s %-10s %-8s\n", "deliveries/s", "p50_us", "p99_us", "max_us", "complete");
+	printf("%-14.0f %-10.1f %-10.1f %-10.1f %-8s\n", complete ? (double)messages * receivers / seconds : 0.0,
+		   Percentile(latencies, 0.50), Percentile(latencies, 0.99), latencies.empty() ? 0.0 : latencies.back(),
+		   complete ? "yes" : "NO");
+	return complete ? 0 : 1;
+}
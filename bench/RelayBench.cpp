@@ -0,0 +1,229 @@
+/**
+ * @file RelayBench.cpp
+ * @brief Relay throughput of the chat server core over each transport.
+ *
+ * Runs one RelayEngine with one sending client and a number of receiving
+ * clients, all in this process, once per transport:
+ *
+ * - mem:  in-memory loopback connections, which measures the relay engine itself;
+ * - unix: Unix domain sockets (not on Windows);
+ * - tcp:  TCP over 127.0.0.1.
+ *
+ * The sender writes chat lines as fast as it can, the server thread relays them
+ * exactly like the server loop does, and the run ends when every receiver got
+ * every line. Logging and console echo are off so only the relay path is timed.
+ *
+ * Usage: RelayBench [recipients] [messages] [tcpPort]
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "Federation.h"
+#include "Framing.h"
+#include "OutputBatcher.h"
+#include "RelayEngine.h"
+#include "Transport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Bytes of chat text behind the nickname in every message
+#define MESSAGE_TEXT_SIZE 64
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Writes all of data, looping over partial writes
+	bool SendAll(Connection& connection, const char* data, size_t length)
+	{
+		while (length > 0)
+		{
+			long sent = connection.Send(data, length);
+			if (sent <= 0)
+				return false;
+			data += sent;
+			length -= (size_t)sent;
+		}
+		return true;
+	}
+
+	// Counts frames until expected messages arrived
+	void ReceiveLoop(Connection* connection, int expected, std::atomic<int>* failures)
+	{
+		FrameReader reader;
+		std::string payload;
+		char chunk[65536];
+		int received = 0;
+		while (received < expected)
+		{
+			long valueRead = connection->Recv(chunk, sizeof(chunk));
+			if (valueRead <= 0)
+			{
+				(*failures)++;
+				return;
+			}
+			reader.Feed(chunk, (size_t)valueRead);
+			while (reader.Next(payload))
+				received++;
+		}
+	}
+
+	// Runs the relay engine the way the server loop does until stop is set
+	void ServerLoop(RelayEngine& engine, OutputBatcher& batcher, bool socketBacked, const std::atomic<bool>& stop)
+	{
+		while (!stop)
+		{
+			if (socketBacked)
+			{
+				fd_set readfds;
+				FD_ZERO(&readfds);
+				int maxSD = 0;
+				engine.AddToReadSet(readfds, maxSD);
+				struct timeval timeout = { 0, 10000 };
+				if (select(maxSD + 1, &readfds, NULL, NULL, &timeout) > 0)
+					engine.ProcessReadSet(readfds);
+			}
+			else
+			{
+				// Loopback connections have no descriptor; poll them, they are non-blocking
+				for (int i = 0; i < engine.Capacity(); i++)
+				{
+					if (engine.ClientConnection(i) != nullptr)
+						engine.OnReadable(i);
+				}
+			}
+			batcher.FlushDue();
+		}
+	}
+
+	/**
+	 * @return Delivered messages per second, or a negative value if the transport could not be used.
+	 */
+	double Run(Transport& transport, const std::string& endpoint, int recipients, int messages)
+	{
+		std::unique_ptr<Listener> listener = transport.Listen(endpoint, DEFAULT_MAX_CLIENTS);
+		if (!listener)
+			return -1;
+
+		// Standalone node: no peer port, so nothing leaves the process
+		FederationOptions federationOptions;
+		FederationBus federation(federationOptions);
+		OutputBatcher batcher;
+		RelayOptions relayOptions;
+		relayOptions.logMessages = false;
+		relayOptions.echoMessages = false;
+		relayOptions.echoEvents = false;
+		RelayEngine engine(federation, batcher, relayOptions);
+
+		// The sender is client 0, the receivers follow
+		std::vector<std::unique_ptr<Connection>> clients;
+		for (int i = 0; i <= recipients; i++)
+		{
+			std::unique_ptr<Connection> client = transport.Connect(endpoint);
+			std::unique_ptr<Connection> accepted = client ? listener->Accept() : nullptr;
+			if (!accepted)
+				return -1;
+			accepted->SetNonBlocking();
+			engine.AddClient(std::move(accepted));
+			clients.push_back(std::move(client));
+		}
+		listener->Close();
+		bool socketBacked = engine.ClientConnection(0)->Handle() != INVALID_SOCKET;
+
+		std::atomic<bool> stop(false);
+		std::atomic<int> failures(0);
+		std::thread server(ServerLoop, std::ref(engine), std::ref(batcher), socketBacked, std::cref(stop));
+		std::vector<std::thread> receivers;
+		for (int i = 1; i <= recipients; i++)
+			receivers.emplace_back(ReceiveLoop, clients[i].get(), messages, &failures);
+
+		std::string message = "sender: " + std::string(MESSAGE_TEXT_SIZE, 'm');
+		std::string frame;
+		AppendFrame(frame, message.data(), message.size());
+		auto start = Clock::now();
+		for (int i = 0; i < messages; i++)
+		{
+			if (!SendAll(*clients[0], frame.data(), frame.size()))
+			{
+				failures++;
+				break;
+			}
+		}
+		if (failures > 0)
+		{
+			// Unblock the receivers of a failed run
+			for (const auto& client : clients)
+				client->Shutdown();
+		}
+		for (std::thread& receiver : receivers)
+			receiver.join();
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		stop = true;
+		server.join();
+
+		if (failures > 0)
+			return -1;
+		return (double)messages * recipients / seconds;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int recipients = argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_CLIENTS - 1;
+	int messages = argc > 2 ? atoi(argv[2]) : 100000;
+	int tcpPort = argc > 3 ? atoi(argv[3]) : 18080;
+	if (recipients < 1 || recipients >= DEFAULT_MAX_CLIENTS || messages < 1 || tcpPort < 1 || tcpPort > 65535)
+	{
+		fprintf(stderr, "Usage: %s [recipients 1-%d] [messages] [tcpPort]\n", argv[0], DEFAULT_MAX_CLIENTS - 1);
+		return 1;
+	}
+
+	std::unique_ptr<Transport> loopback = CreateLoopbackTransport();
+	std::unique_ptr<Transport> unixTransport = CreateUnixTransport();
+	// Also starts Winsock for the whole run
+	std::unique_ptr<Transport> tcp = CreateTcpTransport();
+
+	struct Case
+	{
+		Transport* transport;
+		std::string endpoint;
+	};
+	std::vector<Case> cases;
+	cases.push_back({ loopback.get(), "relay-bench" });
+#ifndef _WIN32
+	std::string unixPath = "/tmp/relay-bench-" + std::to_string(getpid()) + ".sock";
+	cases.push_back({ unixTransport.get(), unixPath });
+#endif
+	cases.push_back({ tcp.get(), "127.0.0.1:" + std::to_string(tcpPort) });
+
+	printf("recipients=%d messages=%d\n", recipients, messages);
+	printf("%-10s %-16s\n", "transport", "deliveries/s");
+	for (const Case& c : cases)
+	{
+		if (c.transport == nullptr)
+			continue;
+		double rate = Run(*c.transport, c.endpoint, recipients, messages);
+		if (rate < 0)
+			printf("%-10s %-16s\n", c.transport->Name(), "failed");
+		else
+			printf("%-10s %-16.0f\n", c.transport->Name(), rate);
+		fflush(stdout);
+	}
+
+#ifndef _WIN32
+	unlink(unixPath.c_str());
+#endif
+	return 0;
+}
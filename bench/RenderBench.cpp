@@ -0,0 +1,211 @@
+/**
+ * @file RenderBench.cpp
+ * @brief Sustained rendered lines per second from the chat client to a terminal.
+ *
+ * Writes chat lines to a pseudo-terminal while a reader thread drains the
+ * master side, the way a terminal emulator would, and counts the lines that
+ * came out. Two ways of rendering are compared:
+ *
+ * - per-line: the old client, which for every message printed a beep, a color
+ *   switch, the text and a switch back, with stdout line-buffered, so one
+ *   write and one notification per line;
+ * - renderer: lines arrive in bursts (what one read from the server delivers),
+ *   each burst is formatted into one batch and handed to a ConsoleRenderer,
+ *   which writes once per frame tick and rate-limits the notifications.
+ *
+ * The reader does not interpret the escape sequences, so the numbers are the
+ * cost of producing the output and pushing it through the pty, not of drawing
+ * it; a real terminal is slower, which makes fewer, larger writes matter more.
+ *
+ * POSIX only (needs posix_openpt).
+ *
+ * Usage: RenderBench [lines] [burst] [frameMicros]
+ *
+ * @author Nikita Struk
+ * @date October 18, 2026
+ */
+
+#include "ConsoleRenderer.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// Bytes of chat text behind the nickname in every line
+#define MESSAGE_TEXT_SIZE 64
+
+// Color of the rendered lines (light green, the default user color)
+#define LINE_COLOR 10
+
+// Longest a run may take before it is reported as incomplete, in seconds
+#define RUN_TIMEOUT_SECONDS 60
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct RunResult
+	{
+		double linesPerSecond = 0;
+		unsigned long long writes = 0;
+		unsigned long long notifications = 0;
+		bool complete = false;
+	};
+
+	// A pseudo-terminal whose master side is drained and counted by a thread
+	struct Terminal
+	{
+		int master = -1;
+		FILE* slave = nullptr;
+		std::atomic<long long> lines{ 0 };
+		std::thread reader;
+
+		bool Open()
+		{
+			master = posix_openpt(O_RDWR | O_NOCTTY);
+			if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+				return false;
+			const char* name = ptsname(master);
+			int slaveFd = name ? open(name, O_WRONLY | O_NOCTTY) : -1;
+			if (slaveFd < 0)
+				return false;
+			slave = fdopen(slaveFd, "w");
+			if (!slave)
+				return false;
+			reader = std::thread([this]()
+			{
+				char chunk[65536];
+				while (true)
+				{
+					ssize_t valueRead = read(master, chunk, sizeof(chunk));
+					if (valueRead <= 0)
+						return; // EIO once the slave side is closed
+					lines += std::count(chunk, chunk + valueRead, '\n');
+				}
+			});
+			return true;
+		}
+
+		// Waits until target lines came out of the terminal or the deadline passes
+		bool WaitFor(long long target, Clock::time_point deadline)
+		{
+			while (lines < target)
+			{
+				if (Clock::now() > deadline)
+					return false;
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+			return true;
+		}
+
+		~Terminal()
+		{
+			if (slave)
+				fclose(slave);
+			if (reader.joinable())
+				reader.join();
+			if (master >= 0)
+				close(master);
+		}
+	};
+
+	std::string MakeLine()
+	{
+		return "sender: " + std::string(MESSAGE_TEXT_SIZE, 'm');
+	}
+
+	// The old receive loop: beep, color, text, reset and newline for every message
+	RunResult RunPerLine(int lines)
+	{
+		RunResult result;
+		Terminal terminal;
+		if (!terminal.Open())
+			return result;
+		setvbuf(terminal.slave, nullptr, _IOLBF, BUFSIZ);
+		std::string line = MakeLine();
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < lines; i++)
+		{
+			fputs("\a", terminal.slave);
+			fprintf(terminal.slave, "\033[%dm", 92);
+			fputs(line.c_str(), terminal.slave);
+			fprintf(terminal.slave, "\033[%dm", 37);
+			fputs("\n", terminal.slave);
+		}
+		result.complete = terminal.WaitFor(lines, start + std::chrono::seconds(RUN_TIMEOUT_SECONDS));
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		result.linesPerSecond = result.complete ? lines / seconds : 0;
+		result.writes = (unsigned long long)lines; // Line-buffered: the newline flushes
+		result.notifications = (unsigned long long)lines;
+		return result;
+	}
+
+	// The renderer: one formatted batch per burst, written once per frame tick
+	RunResult RunRenderer(int lines, int burst, unsigned int frameMicros)
+	{
+		RunResult result;
+		Terminal terminal;
+		if (!terminal.Open())
+			return result;
+		RenderOptions options;
+		options.frameMicros = frameMicros;
+		ConsoleRenderer renderer(terminal.slave, options);
+		renderer.Start();
+		std::string line = MakeLine();
+		std::string batch;
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < lines; i += burst)
+		{
+			int count = std::min(burst, lines - i);
+			batch.clear();
+			for (int j = 0; j < count; j++)
+			{
+				renderer.Format(batch, LINE_COLOR, line.data(), line.size());
+				batch += '\n';
+			}
+			renderer.Write(batch, (size_t)count);
+			renderer.Notify();
+		}
+		renderer.Stop();
+		result.complete = terminal.WaitFor(lines, start + std::chrono::seconds(RUN_TIMEOUT_SECONDS));
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		RenderStats stats = renderer.Stats();
+		result.linesPerSecond = result.complete ? lines / seconds : 0;
+		result.writes = stats.writes;
+		result.notifications = stats.notifications;
+		return result;
+	}
+
+	void PrintRow(const char* mode, const RunResult& result)
+	{
+		printf("%-10s %-14.0f %-10llu %-14llu %-8s\n", mode, result.linesPerSecond, result.writes,
+			   result.notifications, result.complete ? "yes" : "NO");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int lines = argc > 1 ? atoi(argv[1]) : 200000;
+	int burst = argc > 2 ? atoi(argv[2]) : 64;
+	int frameMicros = argc > 3 ? atoi(argv[3]) : DEFAULT_RENDER_FRAME_US;
+	if (lines < 1 || burst < 1 || frameMicros < 0)
+	{
+		fprintf(stderr, "Usage: %s [lines] [burst] [frameMicros]\n", argv[0]);
+		return 1;
+	}
+
+	printf("lines=%d burst=%d frameMicros=%d\n", lines, burst, frameMicros);
+	printf("%-10s %-14s %-10s %-14s %-8s\n", "mode", "lines/s", "writes", "notifications", "complete");
+	RunResult perLine = RunPerLine(lines);
+	PrintRow("per-line", perLine);
+	RunResult rendered = RunRenderer(lines, burst, (unsigned int)frameMicros);
+	PrintRow("renderer", rendered);
+	return perLine.complete && rendered.complete ? 0 : 1;
+}
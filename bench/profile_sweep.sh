@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+# Runs chat_server under a series of profiles, measures each one with ProfileBench
+# and appends the results to a CSV file (one row per run).
+#
+# Usage: bench/profile_sweep.sh [buildDir] [resultsFile]
+#   buildDir     directory holding chat_server and ProfileBench (default: build)
+#   resultsFile  CSV file the rows are appended to (default: profile-sweep.csv)
+#
+# Environment: RECEIVERS (8), MESSAGES (100000), PACED_RATE (5000 lines/s),
+# PORT (18500), RUNS (1 run per profile).
+#
+# Every profile starts from the same base (no logging, no offline queue, enough
+# client slots and backlog for the benchmark) and changes one or a few settings;
+# edit PROFILES below to sweep something else.
+set -eu
+
+BUILD_DIR=${1:-build}
+RESULTS=${2:-profile-sweep.csv}
+RECEIVERS=${RECEIVERS:-8}
+MESSAGES=${MESSAGES:-100000}
+PACED_RATE=${PACED_RATE:-5000}
+PORT=${PORT:-18500}
+RUNS=${RUNS:-1}
+
+SERVER=$(cd "$BUILD_DIR" && pwd)/chat_server
+BENCH=$(cd "$BUILD_DIR" && pwd)/ProfileBench
+for binary in "$SERVER" "$BENCH"; do
+	if [ ! -x "$binary" ]; then
+		echo "Missing $binary; build the project first (cmake --build $BUILD_DIR)" >&2
+		exit 1
+	fi
+done
+
+MAX_CLIENTS=$((RECEIVERS + 1 > 10 ? RECEIVERS + 1 : 10))
+BASE="--port $PORT --log none --offline off --max-clients $MAX_CLIENTS --backlog 64"
+
+# name|settings on top of BASE
+PROFILES=(
+	"default|"
+	"nodelay-off|--tcp-nodelay off"
+	"batch-200us|--batch-window-us 200"
+	"batch-1ms|--batch-window-us 1000"
+	"read-16k|--read-buffer 16k"
+	"read-64k|--read-buffer 64k"
+	"sockbuf-256k|--so-rcvbuf 256k --so-sndbuf 256k"
+	"sockbuf-4m|--so-rcvbuf 4m --so-sndbuf 4m"
+	"cpu-0|--cpu 0"
+	"log-file|--log file"
+	"throughput|--read-buffer 64k --so-rcvbuf 1m --so-sndbuf 1m --batch-window-us 200"
+)
+
+# The server runs in a scratch directory so server.log and offline/ stay out of the tree
+WORK=$(mktemp -d)
+SERVER_PID=
+cleanup() {
+	if [ -n "$SERVER_PID" ]; then
+		kill "$SERVER_PID" 2>/dev/null || true
+	fi
+	rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+if [ ! -f "$RESULTS" ]; then
+	echo "date,profile,settings,receivers,messages,paced_rate,deliveries_per_s,p50_us,p99_us,max_us,complete" > "$RESULTS"
+fi
+
+printf "%-14s %-14s %-10s %-10s %-10s %-8s\n" "profile" "deliveries/s" "p50_us" "p99_us" "max_us" "complete"
+for entry in "${PROFILES[@]}"; do
+	name=${entry%%|*}
+	settings=${entry#*|}
+	for run in $(seq 1 "$RUNS"); do
+		# shellcheck disable=SC2086 # settings are split into arguments on purpose
+		(cd "$WORK" && exec "$SERVER" $BASE $settings < /dev/null > "server-$name-$run.log" 2>&1) &
+		SERVER_PID=$!
+		output=$("$BENCH" "127.0.0.1:$PORT" "$RECEIVERS" "$MESSAGES" "$PACED_RATE" 2>&1) || true
+		kill "$SERVER_PID" 2>/dev/null || true
+		wait "$SERVER_PID" 2>/dev/null || true
+		SERVER_PID=
+
+		read -r rate p50 p99 max complete <<< "$(echo "$output" | tail -n 1)"
+		if [ "${complete:-}" != "yes" ] && [ "${complete:-}" != "NO" ]; then
+			echo "$name: ProfileBench failed: $output" >&2
+			rate=0 p50=0 p99=0 max=0 complete=NO
+		fi
+		printf "%-14s %-14s %-10s %-10s %-10s %-8s\n" "$name" "$rate" "$p50" "$p99" "$max" "$complete"
+		echo "$(date -u +%Y-%m-%dT%H:%M:%SZ),$name,\"$settings\",$RECEIVERS,$MESSAGES,$PACED_RATE,$rate,$p50,$p99,$max,$complete" >> "$RESULTS"
+	done
+done
+echo "Results appended to $RESULTS"